@@ -54,6 +54,9 @@ void init_BoxArray(py::module &m) {
         .def_property_readonly("empty", &BoxArray::empty)
         .def_property_readonly("numPts", &BoxArray::numPts)
         .def_property_readonly("d_numPts", &BoxArray::d_numPts)
+
+        .def("__eq__", &BoxArray::operator==)
+        .def("__ne__", &BoxArray::operator!=)
 /*
         .def_property("type",
             py::overload_cast<>(&BoxArray::type, py::const_),
@@ -39,6 +39,9 @@ void init_DistributionMapping(py::module &m) {
             py::arg("boxes"), py::arg("nprocs")
         )
 
+        .def("__eq__", &DistributionMapping::operator==)
+        .def("__ne__", &DistributionMapping::operator!=)
+
         .def("define",
             [](DistributionMapping & dm, BoxArray const & boxes) {
                 dm.define(boxes);
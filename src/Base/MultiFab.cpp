@@ -4,6 +4,9 @@
  * License: BSD-3-Clause-LBNL
  */
 #include "pyAMReX.H"
+#include "Base/Arrow.H"
+#include "Base/Histogram.H"
+#include "Base/Parser.H"
 
 #include <AMReX_BoxArray.H>
 #include <AMReX_DistributionMapping.H>
@@ -11,10 +14,18 @@
 #include <AMReX_FabArray.H>
 #include <AMReX_FabArrayBase.H>
 #include <AMReX_FabFactory.H>
+#include <AMReX_Geometry.H>
+#include <AMReX_GpuContainers.H>
+#include <AMReX_Loop.H>
 #include <AMReX_MultiFab.H>
 
+#include <functional>
+#include <map>
 #include <memory>
+#include <optional>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace {
     void check_comp(amrex::MultiFab const & mf, const int comp, std::string const name)
@@ -891,6 +902,118 @@ void init_MultiFab(py::module &m)
         .def("weighted_sync", &MultiFab::WeightedSync)
         //.def("override_sync", py::overload_cast< iMultiFab const &, Periodicity const & >(&MultiFab::OverrideSync))
 
+        .def("_histogram",
+             [](MultiFab const & mf, int comp, int nbins, std::optional<std::pair<double, double>> range,
+                bool local, int root)
+             {
+                 check_comp(mf, comp, "histogram");
+                 if (!range) {
+                     double const lo = mf.min(comp, 0, local);
+                     double const hi = mf.max(comp, 0, local);
+                     range = lo < hi ? std::make_pair(lo, hi) : std::make_pair(lo - 0.5, hi + 0.5);
+                 }
+                 HistogramBins const bins({nbins}, {*range});
+
+                 std::vector<double> hist;
+                 {
+                     py::gil_scoped_release release;
+                     hist = accumulate_histogram(bins, mf.local_size(),
+                         [&](int li, std::vector<double> & thread_hist) {
+                             FArrayBox const & fab = mf.atLocalIdx(li);
+                             Box const & fab_box = fab.box();
+#ifdef AMREX_USE_GPU
+                             std::vector<Real> staging(fab_box.numPts());
+                             Gpu::copyAsync(Gpu::deviceToHost, fab.dataPtr(comp),
+                                            fab.dataPtr(comp) + fab_box.numPts(), staging.data());
+                             Gpu::streamSynchronize();
+                             Real const * const data = staging.data();
+#else
+                             Real const * const data = fab.dataPtr(comp);
+#endif
+                             Dim3 const end = amrex::ubound(fab_box);
+                             Array4<Real const> const a(data, amrex::lbound(fab_box),
+                                                        Dim3{end.x + 1, end.y + 1, end.z + 1}, 1);
+
+                             // valid cells only
+                             amrex::LoopOnCpu(mf.box(mf.IndexArray()[li]), [&](int i, int j, int k) {
+                                 double const v = a(i, j, k);
+                                 std::size_t idx;
+                                 if (bins.index(&v, idx)) { thread_hist[idx] += 1.0; }
+                             });
+                         });
+                 }
+                 return py::make_tuple(reduce_histogram(hist, bins, local, root), *range);
+             },
+             py::arg("comp"), py::arg("bins"), py::arg("range"), py::arg("local"), py::arg("root"),
+             "Histogram of the valid cells of a component, see histogram."
+        )
+
+        .def("fill_from_expression",
+             [](MultiFab & mf, NamedExpression const & expr, Geometry const & geom, int comp, double t,
+                int ngrow)
+             {
+                 check_comp(mf, comp, "fill_from_expression");
+                 check_nghost(mf, ngrow, "fill_from_expression");
+                 py::gil_scoped_release release;
+                 fill_from_expression(mf, expr, geom, comp, t, ngrow);
+             },
+             py::arg("expr"), py::arg("geom"), py::arg("comp") = 0, py::arg("t") = 0.0,
+             py::kw_only(), py::arg("ngrow") = 0,
+             "Set a component to a Parser expression in the variables x, y, z (per dimension) and t.\n\n"
+             "Evaluated at cell centers (nodes in nodal directions) of the valid cells and ngrow ghost cells,\n"
+             "with a tiled OpenMP or GPU ParallelFor."
+        )
+        .def("fill_from_expression",
+             [](MultiFab & mf, std::string const & expr, Geometry const & geom, int comp, double t,
+                std::map<std::string, double> const & constants, int ngrow)
+             {
+                 check_comp(mf, comp, "fill_from_expression");
+                 check_nghost(mf, ngrow, "fill_from_expression");
+                 NamedExpression const parsed(expr, mesh_expression_vars(), constants);
+                 py::gil_scoped_release release;
+                 fill_from_expression(mf, parsed, geom, comp, t, ngrow);
+             },
+             py::arg("expr"), py::arg("geom"), py::arg("comp") = 0, py::arg("t") = 0.0,
+             py::kw_only(), py::arg("constants") = std::map<std::string, double>{}, py::arg("ngrow") = 0,
+             "Set a component to a math expression in the variables x, y, z (per dimension) and t,\n"
+             "e.g., \"exp(-(x^2+y^2)/s)\" with constants={\"s\": 0.1}.\n\n"
+             "constants and ngrow are keyword-only, as ngrow of the Parser overload."
+        )
+
+        /* Arrow PyCapsule interface */
+        .def("__arrow_c_stream__",
+             [](py::object const & self, py::object const & /* requested_schema */)
+             {
+                 using namespace pyAMReX::arrow;
+                 auto const & mf = self.cast<MultiFab const &>();
+                 auto const owner = arrow_keep_alive(self);
+
+                 ArrowColumns schema;
+                 for (int comp = 0; comp < mf.nComp(); ++comp) {
+                     schema.names.push_back("comp_" + std::to_string(comp));
+                     schema.formats.emplace_back(arrow_format<Real>());
+                 }
+
+                 std::vector<std::function<std::shared_ptr<ArrowColumns const>()>> batches;
+                 for (int li = 0; li < mf.local_size(); ++li) {
+                     batches.emplace_back([&mf, li, owner]() {
+                         FArrayBox const & fab = mf.atLocalIdx(li);
+                         auto cols = std::make_shared<ArrowColumns>();
+                         cols->length = fab.box().numPts();
+                         cols->owner = owner;
+                         for (int comp = 0; comp < fab.nComp(); ++comp)
+                             cols->add("comp_" + std::to_string(comp), fab.dataPtr(comp));
+                         return std::shared_ptr<ArrowColumns const>(cols);
+                     });
+                 }
+                 return arrow_stream_capsule(std::move(schema), std::move(batches));
+             },
+             py::arg("requested_schema") = py::none(),
+             "Arrow PyCapsule of a stream with one record batch per local box.\n\n"
+             "Columns comp_0, comp_1, ... hold the components of a box, including its ghost cells,\n"
+             "flattened in Fortran (column-major) order. On CPU, columns are zero-copy views."
+        )
+
         /* Init & Finalize */
         .def_static("initialize", &MultiFab::Initialize)
         .def_static("finalize", &MultiFab::Finalize)
@@ -140,5 +140,6 @@ void make_PODVector(py::module &m, std::string typestr)
 void init_PODVector(py::module& m) {
     make_PODVector<ParticleReal> (m, "real");
     make_PODVector<int> (m, "int");
+    make_PODVector<unsigned int> (m, "uint");
     make_PODVector<uint64_t> (m, "uint64");
 }
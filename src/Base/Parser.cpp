@@ -0,0 +1,44 @@
+/* Copyright 2024 The AMReX Community
+ *
+ * Authors: Axel Huebl
+ * License: BSD-3-Clause-LBNL
+ */
+#include "pyAMReX.H"
+#include "Base/Parser.H"
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+
+void init_Parser(py::module &m)
+{
+    py::class_< NamedExpression >(m, "Parser",
+        "A math expression compiled with amrex::Parser, e.g., \"exp(-(x^2+y^2)/s)\".\n\n"
+        "Used variables are named by vars, further symbols must be given as constants.")
+        .def("__repr__",
+             [](NamedExpression const & p) {
+                 return "<amrex.Parser of '" + p.parser.expr() + "'>";
+             }
+        )
+
+        .def(py::init< std::string const &, std::vector<std::string>, std::map<std::string, double> const & >(),
+             py::arg("expr"), py::arg("vars") = std::vector<std::string>{},
+             py::arg("constants") = std::map<std::string, double>{}
+        )
+
+        .def_property_readonly("expr", [](NamedExpression const & p) { return p.parser.expr(); })
+        .def_property_readonly("vars", [](NamedExpression const & p) { return p.names; },
+                               "The variables, in the order of the arguments of a call")
+        .def_property_readonly("symbols", [](NamedExpression const & p) { return p.parser.symbols(); },
+                               "The variables used in the expression")
+
+        .def("__call__",
+             [](NamedExpression const & p, py::args const & args) {
+                 return p.evaluate(args.cast<std::vector<double>>());
+             },
+             "Evaluate on host, with one value per variable"
+        )
+    ;
+}
@@ -4,6 +4,7 @@
  */
 #include "pyAMReX.H"
 
+#include <AMReX_AsyncOut.H>
 #include <AMReX_PlotFileUtil.H>
 #include <AMReX_Print.H>
 #include <AMReX_Vector.H>
@@ -20,7 +21,12 @@ void init_PlotFileUtil(py::module &m) {
         py::arg("varnames"), py::arg("geom"), py::arg("time"),
         py::arg("level_step"), py::arg("versionName") = "HyperCLaw-V1.1",
         py::arg("levelPrefix") = "Level_", py::arg("mfPrefix") = "Cell",
-        py::arg_v("extra_dirs", Vector<std::string>(), "list[str]"));
+        py::arg_v("extra_dirs", Vector<std::string>(), "list[str]"),
+        py::call_guard<py::gil_scoped_release>());
+
+  auto mao = m.def_submodule("AsyncOut");
+  mao.def("use_async_out", &AsyncOut::UseAsyncOut,
+          "True if AMReX writes plotfiles and particles on its own background thread (amrex.async_out=1)");
 
   py::class_<PlotFileData>(m, "PlotFileData")
       // explicitly provide constructor argument types
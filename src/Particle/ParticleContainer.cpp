@@ -5,33 +5,19 @@
  */
 #include "ParticleContainer.H"
 
+#include "ParticleBins.H"
+#include "ParticleIdIndex.H"
+
 #include <AMReX_Particle.H>
 
+#include <algorithm>
 #include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
 
 
-namespace
-{
-    using namespace amrex;
-
-    // Note - this function MUST be consistent with AMReX_Particle.H
-    Long unpack_id (uint64_t idcpu) {
-        Long r = 0;
-
-        uint64_t sign = idcpu >> 63;  // extract leftmost sign bit
-        uint64_t val  = ((idcpu >> 24) & 0x7FFFFFFFFF);  // extract next 39 id bits
-
-        Long lval = static_cast<Long>(val);  // bc we take -
-        r = (sign) ? lval : -lval;
-        return r;
-    }
-
-    // Note - this function MUST be consistent with AMReX_Particle.H
-    int unpack_cpu (uint64_t idcpu) {
-        return static_cast<int>(idcpu & 0x00FFFFFF);
-    }
-}
-
 // forward declarations
 void init_ParticleContainer_FHDeX(py::module& m);
 void init_ParticleContainer_HiPACE(py::module& m);
@@ -41,6 +27,49 @@ void init_ParticleContainer_WarpX(py::module& m);
 void init_ParticleContainer(py::module& m) {
     using namespace amrex;
 
+    py::class_<ParticleIdIndex>(m, "ParticleIdIndex",
+        "Hash map from packed idcpu to the (level, grid, tile, index) of local particles, "
+        "see ParticleContainer.build_id_index")
+        .def("__len__", &ParticleIdIndex::size)
+        .def("__contains__",
+             [](ParticleIdIndex const & index, uint64_t idcpu) { return index.map.count(idcpu) > 0; }
+        )
+        .def("location",
+             [](ParticleIdIndex const & index, uint64_t idcpu) -> std::optional<std::tuple<int, int, int, int>> {
+                 auto const it = index.map.find(idcpu);
+                 if (it == index.map.end()) { return std::nullopt; }
+                 auto const & loc = it->second;
+                 return std::make_tuple(loc.lev, loc.grid, loc.tile, loc.index);
+             },
+             py::arg("idcpu"),
+             "(level, grid, tile, index) of a particle, or None"
+        )
+    ;
+
+    py::class_<ParticleBins>(m, "ParticleBins",
+        "Particles of a tile binned by cells, as amrex::DenseBins, see ParIter.build_bins")
+        .def("__len__", &ParticleBins::numBins)
+        .def_property_readonly("num_bins", &ParticleBins::numBins)
+        .def_property_readonly("num_items", &ParticleBins::numItems)
+        .def_readonly("box", &ParticleBins::box, "the binned cells")
+        .def_readonly("bin_size", &ParticleBins::bin_size, "cells per bin in each direction")
+        .def_readonly("bin_box", &ParticleBins::bin_box, "box coarsened by bin_size, one cell per bin")
+        .def_property_readonly("permutation",
+             [](py::object const & self) {
+                 auto & bins = self.cast<ParticleBins &>();
+                 return py::array_t<unsigned int>(bins.permutation.size(), bins.permutation.data(), self);
+             },
+             "Particle indices of the tile, ordered by bin (zero-copy view)"
+        )
+        .def_property_readonly("offsets",
+             [](py::object const & self) {
+                 auto & bins = self.cast<ParticleBins &>();
+                 return py::array_t<unsigned int>(bins.offsets.size(), bins.offsets.data(), self);
+             },
+             "Start of each bin in permutation, num_bins + 1 entries (zero-copy view)"
+        )
+    ;
+
     // TODO: we might need to move all or most of the defines in here into a
     //       test/example submodule, so they do not collide with downstream projects
 
@@ -56,6 +85,10 @@ void init_ParticleContainer(py::module& m) {
     // used in tests
     make_ParticleContainer_and_Iterators<Particle<2, 1>, 3, 1>(m);
 
+    // converting copies between the legacy AoS + SoA and pure SoA layouts
+    make_copy_particles<SoAParticle<AMREX_SPACEDIM, 0>, AMREX_SPACEDIM, 0, Particle<2, 1>, 3, 1>();
+    make_copy_particles<Particle<2, 1>, 3, 1, SoAParticle<AMREX_SPACEDIM, 0>, AMREX_SPACEDIM, 0>();
+
     // application codes
     init_ParticleContainer_FHDeX(m);
     init_ParticleContainer_HiPACE(m);
@@ -63,6 +96,48 @@ void init_ParticleContainer(py::module& m) {
     init_ParticleContainer_WarpX(m);
 
     // for particle idcpu arrays
-    m.def("unpack_ids", py::vectorize(unpack_id));
-    m.def("unpack_cpus", py::vectorize(unpack_cpu));
+    using IdCpuArray = py::array_t<uint64_t, py::array::c_style | py::array::forcecast>;
+    m.def("unpack_ids",
+        [](IdCpuArray const & idcpu) {
+            py::array_t<Long> ids(std::vector<py::ssize_t>(idcpu.shape(), idcpu.shape() + idcpu.ndim()));
+            uint64_t const * const src = idcpu.data();
+            Long * const dst = ids.mutable_data();
+            {
+                py::gil_scoped_release release;
+                unpack_ids(src, dst, idcpu.size());
+            }
+            return ids;
+        },
+        py::arg("idcpu"), "The particle ids of packed idcpu values"
+    );
+    m.def("unpack_cpus",
+        [](IdCpuArray const & idcpu) {
+            py::array_t<int> cpus(std::vector<py::ssize_t>(idcpu.shape(), idcpu.shape() + idcpu.ndim()));
+            uint64_t const * const src = idcpu.data();
+            int * const dst = cpus.mutable_data();
+            {
+                py::gil_scoped_release release;
+                unpack_cpus(src, dst, idcpu.size());
+            }
+            return cpus;
+        },
+        py::arg("idcpu"), "The MPI ranks (cpus) of packed idcpu values"
+    );
+    m.def("pack_idcpu",
+        [](py::array_t<Long, py::array::c_style | py::array::forcecast> const & ids,
+           py::array_t<int, py::array::c_style | py::array::forcecast> const & cpus) {
+            if (ids.ndim() != cpus.ndim() || !std::equal(ids.shape(), ids.shape() + ids.ndim(), cpus.shape()))
+                throw std::runtime_error("pack_idcpu: ids and cpus must have the same shape");
+            py::array_t<uint64_t> idcpu(std::vector<py::ssize_t>(ids.shape(), ids.shape() + ids.ndim()));
+            Long const * const src_ids = ids.data();
+            int const * const src_cpus = cpus.data();
+            uint64_t * const dst = idcpu.mutable_data();
+            {
+                py::gil_scoped_release release;
+                pack_ids_and_cpus(src_ids, src_cpus, dst, ids.size());
+            }
+            return idcpu;
+        },
+        py::arg("ids"), py::arg("cpus"), "Pack particle ids and MPI ranks (cpus) into idcpu values"
+    );
 }
@@ -0,0 +1,270 @@
+"""
+This file is part of pyAMReX
+
+Copyright 2024 AMReX community
+Authors: Axel Huebl
+License: BSD-3-Clause-LBNL
+"""
+
+import threading
+from collections import deque
+from concurrent.futures import Future, ThreadPoolExecutor
+
+
+def _can_write_on_thread(amr):
+    """
+    Whether AMReX output may run on a background thread of this process
+
+    Output calls MPI collectives on the communicator of the simulation. These
+    must not run concurrently with collectives of the main thread, unless
+    there is a single MPI rank and MPI provides MPI_THREAD_MULTIPLE.
+    """
+    if not amr.Config.have_mpi:
+        return True
+    if amr.ParallelDescriptor.NProcs() > 1:
+        return False
+    try:
+        from mpi4py import MPI
+    except ImportError:
+        return False
+    return MPI.Query_thread() == MPI.THREAD_MULTIPLE
+
+
+class AsyncWriter:
+    """
+    Write plotfiles and particles on a background thread
+
+    Each write first snapshots the data into staging buffers, which are reused
+    by later writes with the same layout, then returns a
+    concurrent.futures.Future while a background thread writes the snapshot.
+    Writes complete in the order they were submitted.
+
+    If AMReX's own asynchronous output is enabled (amrex.async_out = 1, see
+    AsyncOut.use_async_out), AMReX snapshots and writes in the background and
+    the writes here return completed futures. The same holds with more than
+    one MPI rank, or without MPI_THREAD_MULTIPLE, where writing on a thread of
+    this process is not safe: writes are then synchronous, so prefer
+    amrex.async_out in parallel runs.
+
+    Parameters
+    ----------
+    max_bytes : int
+        Memory budget for pending snapshots on this MPI rank, default: none.
+        Writes block until older writes finished if a new snapshot would
+        exceed it; larger snapshots are written synchronously, once all
+        older writes finished.
+
+    Examples
+    --------
+    >>> writer = amr.AsyncWriter(max_bytes=2**30)
+    >>> varnames = amr.Vector_string(["rho"])
+    >>> writer.write_single_level_plotfile("plt00010", mf, varnames, geom, t, 10)
+    >>> writer.write_plotfile(pc, "plt00010", "particles")
+    >>> ...  # advance the simulation
+    >>> writer.wait()
+    """
+
+    def __init__(self, max_bytes=None):
+        self.max_bytes = max_bytes
+        self._executor = None
+        self._asynchronous = None
+        self._lock = threading.Lock()
+        self._pending = deque()  # (future, nbytes)
+        self._free_mfs = []
+        self._free_pcs = {}  # ParticleContainer type: list of staging containers
+
+    def _is_asynchronous(self, amr):
+        if self._asynchronous is None:
+            self._asynchronous = not amr.AsyncOut.use_async_out() and (
+                _can_write_on_thread(amr)
+            )
+            if self._asynchronous:
+                self._executor = ThreadPoolExecutor(
+                    max_workers=1, thread_name_prefix="amrex_async_writer"
+                )
+        return self._asynchronous
+
+    def _make_room(self, nbytes):
+        """Wait for old writes until a snapshot of nbytes fits the budget"""
+        if self.max_bytes is None:
+            return True
+        if nbytes > self.max_bytes:
+            return False
+        while True:
+            running = [(f, n) for f, n in self._pending if not f.done()]
+            if sum(n for _, n in running) + nbytes <= self.max_bytes:
+                return True
+            # wait for the oldest write, errors are raised by wait()
+            running[0][0].exception()
+
+    def _submit(self, write, nbytes, release):
+        """Write a snapshot on the background thread, then release its staging buffers"""
+
+        def task():
+            try:
+                write()
+            finally:
+                with self._lock:
+                    release()
+
+        # forget finished writes, but keep failed ones for wait()
+        self._pending = deque(
+            (f, n) for f, n in self._pending if not f.done() or f.exception()
+        )
+        future = self._executor.submit(task)
+        self._pending.append((future, nbytes))
+        return future
+
+    def _run(self, write):
+        """Write synchronously, after all pending writes, as a completed future"""
+        # keep the order of writes and never run two AMReX writes at once;
+        # errors of pending writes are kept for wait()
+        for pending, _ in self._pending:
+            pending.exception()
+
+        future = Future()
+        try:
+            future.set_result(write())
+        except Exception as e:
+            future.set_exception(e)
+        return future
+
+    def write_single_level_plotfile(
+        self, plotfilename, mf, varnames, geom, time, level_step, **kwargs
+    ):
+        """
+        Write a single-level plotfile, as amr.write_single_level_plotfile
+
+        The valid cells of mf are snapshot before this returns.
+
+        Returns
+        -------
+        A concurrent.futures.Future of the write.
+        """
+        from inspect import getmodule
+
+        amr = getmodule(mf)
+
+        def write(data=mf):
+            return amr.write_single_level_plotfile(
+                plotfilename, data, varnames, geom, time, level_step, **kwargs
+            )
+
+        nbytes = mf.box_array().numPts * mf.n_comp * 8
+        if not self._is_asynchronous(amr) or not self._make_room(nbytes):
+            return self._run(write)
+
+        ba, dm = mf.box_array(), mf.dm()
+        with self._lock:
+            staging = next(
+                (
+                    s
+                    for s in self._free_mfs
+                    if s.n_comp == mf.n_comp and s.box_array() == ba and s.dm() == dm
+                ),
+                None,
+            )
+            if staging is None:
+                self._free_mfs.clear()  # layout changed, e.g., after regridding
+                staging = amr.MultiFab(ba, dm, mf.n_comp, 0)
+            else:
+                self._free_mfs.remove(staging)
+
+        amr.copy_mfab(
+            dst=staging, src=mf, srccomp=0, dstcomp=0, numcomp=mf.n_comp, nghost=0
+        )
+        return self._submit(
+            lambda: write(staging), nbytes, lambda: self._free_mfs.append(staging)
+        )
+
+    def write_plotfile(self, pc, dir, name, **kwargs):
+        """
+        Write particles to a plotfile, as ParticleContainer.write_plotfile
+
+        All particles are snapshot before this returns.
+
+        Returns
+        -------
+        A concurrent.futures.Future of the write.
+        """
+        return self._write_particles(pc, "write_plotfile", dir, name, **kwargs)
+
+    def checkpoint(self, pc, dir, name, **kwargs):
+        """
+        Write particles for a restart, as ParticleContainer.checkpoint
+
+        All particles are snapshot before this returns.
+
+        Returns
+        -------
+        A concurrent.futures.Future of the write.
+        """
+        return self._write_particles(pc, "checkpoint", dir, name, **kwargs)
+
+    def _write_particles(self, pc, method, dir, name, **kwargs):
+        from inspect import getmodule
+
+        amr = getmodule(pc)
+        pc_type = type(pc)
+
+        if not self._is_asynchronous(amr):
+            return self._run(lambda: getattr(pc, method)(dir, name, **kwargs))
+
+        # upper bound of the snapshot size: idcpu, Reals as double, ints
+        num_real = pc.num_position_components + pc.num_struct_real + pc.num_real_comps
+        num_int = pc.num_struct_int + pc.num_int_comps
+        nbytes = pc.total_number_of_particles(False, True) * (
+            8 + 8 * num_real + 4 * num_int
+        )
+        if not self._make_room(nbytes):
+            return self._run(lambda: getattr(pc, method)(dir, name, **kwargs))
+
+        with self._lock:
+            free = self._free_pcs.setdefault(pc_type, [])
+            staging = free.pop() if free else None
+        # runtime components can only be added: start over if pc has fewer
+        if staging is None or (
+            staging.num_runtime_real_comps > pc.num_runtime_real_comps
+            or staging.num_runtime_int_comps > pc.num_runtime_int_comps
+        ):
+            staging = pc_type()
+        pc._snapshot_into(staging)
+
+        return self._submit(
+            lambda: getattr(staging, method)(dir, name, **kwargs),
+            nbytes,
+            lambda: self._free_pcs[pc_type].append(staging),
+        )
+
+    def wait(self):
+        """
+        Wait for all pending writes
+
+        Raises the first error of a failed write.
+        """
+        error = None
+        while self._pending:
+            future, _ = self._pending.popleft()
+            e = future.exception()
+            if e is not None and error is None:
+                error = e
+        if error is not None:
+            raise error
+
+    def close(self):
+        """Wait for all pending writes and stop the background thread"""
+        try:
+            self.wait()
+        finally:
+            if self._executor is not None:
+                self._executor.shutdown()
+            self._executor = None
+            self._asynchronous = None
+            self._free_mfs.clear()
+            self._free_pcs.clear()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
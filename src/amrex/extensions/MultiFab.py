@@ -173,6 +173,45 @@ def copy_multifab(amr, self):
     return mf
 
 
+def mf_histogram(self, comp=0, bins=10, range=None, local=False, root=0):
+    """
+    Histogram of the values of a component in the valid cells, computed in C++
+
+    Per-thread histograms are accumulated over all boxes with OpenMP and
+    summed over all MPI ranks on root with one MPI_Reduce.
+    Call on all MPI ranks, unless local is True.
+
+    Parameters
+    ----------
+    self : amrex.MultiFab
+        A MultiFab class in pyAMReX
+    comp : int
+        Component to histogram
+    bins : int
+        Number of bins
+    range : (float, float)
+        (lower, upper) edges, default: the global min and max of the component.
+        Values outside of the range are ignored.
+    local : bool
+        MPI rank-local boxes only, returned on all ranks
+    root : int
+        MPI rank to sum the histogram on
+
+    Returns
+    -------
+    As numpy.histogram, a tuple of the (float) histogram and its bin edges.
+    If local is False, then all ranks but root will return None.
+    """
+    import numpy as np
+
+    hist, (lo, hi) = self._histogram(
+        comp, bins, None if range is None else tuple(range), local, root
+    )
+    if hist is None:
+        return None
+    return hist, np.linspace(lo, hi, bins + 1)
+
+
 def register_MultiFab_extension(amr):
     """MultiFab helper methods"""
 
@@ -189,5 +228,7 @@ def register_MultiFab_extension(amr):
     amr.MultiFab.to_cupy = mf_to_cupy
     amr.MultiFab.to_xp = mf_to_xp
 
+    amr.MultiFab.histogram = mf_histogram
+
     amr.MultiFab.copy = lambda self: copy_multifab(amr, self)
     amr.MultiFab.copy.__doc__ = copy_multifab.__doc__
@@ -6,10 +6,855 @@ Authors: Axel Huebl
 License: BSD-3-Clause-LBNL
 """
 
+import weakref
+
 from .Iterator import next
 
+# ParticleContainer: ParticleIdIndex, None if it must be rebuilt
+_id_indices = weakref.WeakKeyDictionary()
+
+
+def particle_comp_names(self):
+    """
+    Names of the SoA Real and int components of a particle tile or container, as in to_df.
+
+    Parameters
+    ----------
+    self : amrex.ParticleTile_* or amrex.ParticleContainer_*
+        A ParticleTile or ParticleContainer class in pyAMReX
+
+    Returns
+    -------
+    A tuple of the lists of Real and int component names.
+    """
+    from .StructOfArrays import soa_int_comps, soa_real_comps
+
+    if self.is_soa_particle:
+        real_names = soa_real_comps(self, self.num_real_comps)
+        int_names = soa_int_comps(self, self.num_int_comps)
+    else:
+        real_names = [
+            f"SoA_{name}"
+            for name in soa_real_comps(self, self.num_real_comps, rotate=False)
+        ]
+        int_names = [f"SoA_{name}" for name in soa_int_comps(self, self.num_int_comps)]
+
+    return real_names, int_names
+
+
+def _aos_real_names(self):
+    """Names of the Reals in the legacy AoS layout, as in ArrayOfStructs.to_numpy"""
+    return ["x", "y", "z"][: self.num_position_components] + [
+        f"rdata_{i}" for i in range(self.num_struct_real)
+    ]
+
+
+def _real_column(self, name):
+    """
+    Index of a Real column by name, as used by the C++ helpers
+
+    SoA Real components have indices >= 0, the Reals of the legacy
+    AoS layout (positions, then struct Reals) have indices < 0.
+    """
+    real_names, _ = particle_comp_names(self)
+    if name in real_names:
+        return real_names.index(name)
+    if not self.is_soa_particle:
+        aos_real_names = _aos_real_names(self)
+        if name in aos_real_names:
+            return -aos_real_names.index(name) - 1
+    raise KeyError(f"Unknown Real component '{name}'")
+
+
+def _real_columns(self):
+    """Names and indices of all Real columns, see _real_column"""
+    names, _ = particle_comp_names(self)
+    cols = list(range(len(names)))
+    if not self.is_soa_particle:
+        aos_real_names = _aos_real_names(self)
+        names = names + aos_real_names
+        cols += [-i - 1 for i in range(len(aos_real_names))]
+    return names, cols
+
+
+def _int_column(self, name):
+    """
+    Index of an int column by name, as used by the C++ helpers
+
+    SoA int components have indices >= 0, the struct ints of the legacy
+    AoS layout (idata_0, idata_1, ...) have indices < 0.
+    """
+    _, int_names = particle_comp_names(self)
+    if name in int_names:
+        return int_names.index(name)
+    if not self.is_soa_particle:
+        aos_int_names = [f"idata_{i}" for i in range(self.num_struct_int)]
+        if name in aos_int_names:
+            return -aos_int_names.index(name) - 1
+    raise KeyError(f"Unknown int component '{name}'")
+
+
+def _named_columns(self, comps, collect):
+    """
+    Select components by name, collect their raw columns and name them
+
+    Parameters
+    ----------
+    self : amrex.ParticleContainer_*
+        A ParticleContainer class in pyAMReX
+    comps : list of str
+        Names of the components to collect, default: all.
+        The "idcpu" column is always included.
+    collect : callable
+        Called with the selected SoA Real and int component indices,
+        returns the raw columns of the C++ helpers _to_columns or _gather_to_root.
+
+    Returns
+    -------
+    A dict of component names to 1D NumPy arrays, named as in to_df.
+    """
+    real_names, int_names = particle_comp_names(self)
+
+    def selected(name):
+        return comps is None or name in comps
+
+    real_comps = [i for i, name in enumerate(real_names) if selected(name)]
+    int_comps = [i for i, name in enumerate(int_names) if selected(name)]
+
+    raw = collect(real_comps, int_comps)
+
+    columns = {}
+    if self.is_soa_particle:
+        columns["idcpu"] = raw["idcpu"]
+    else:
+        # same order as the AoS dtype in ArrayOfStructs.to_numpy
+        for name, array in zip(_aos_real_names(self), raw["aos_real"]):
+            if selected(name):
+                columns[name] = array
+        columns["idcpu"] = raw["idcpu"]
+        for i, array in enumerate(raw["aos_int"]):
+            if selected(f"idata_{i}"):
+                columns[f"idata_{i}"] = array
+
+    for i, array in zip(real_comps, raw["real"]):
+        columns[real_names[i]] = array
+    for i, array in zip(int_comps, raw["int"]):
+        columns[int_names[i]] = array
+
+    return columns
+
+
+def pc_to_columns(self, level=None, comps=None, only_valid=True):
+    """
+    Copy the local particles into one contiguous NumPy array per component
+
+    The arrays are filled in C++, in parallel over tiles, without creating
+    per-tile copies in Python.
+
+    Parameters
+    ----------
+    self : amrex.ParticleContainer_*
+        A ParticleContainer class in pyAMReX
+    level : int
+        Copy particles of this mesh-refinement level only, default: all levels
+    comps : list of str
+        Names of the components to copy, default: all.
+        The "idcpu" column is always included.
+    only_valid : bool
+        Skip invalid particles, i.e., particles marked for removal
+
+    Returns
+    -------
+    A dict of component names to 1D NumPy arrays, named as in to_df.
+    """
+    return _named_columns(
+        self,
+        comps,
+        lambda real_comps, int_comps: self._to_columns(
+            level, real_comps, int_comps, only_valid
+        ),
+    )
+
 
-def pc_to_df(self, local=True, comm=None, root_rank=0):
+def pc_gather_to_root(self, root=0, level=None, comps=None, only_valid=True):
+    """
+    Gather the particles of all MPI ranks into one contiguous NumPy array per component on root
+
+    The particle counts of all ranks are exchanged first, then each
+    component is gathered as one typed buffer with MPI_Gatherv, in rank order.
+    This needs no mpi4py and does not pickle particles.
+    Call on all MPI ranks.
+
+    Parameters
+    ----------
+    self : amrex.ParticleContainer_*
+        A ParticleContainer class in pyAMReX
+    root : int
+        MPI rank to gather to
+    level : int
+        Gather particles of this mesh-refinement level only, default: all levels
+    comps : list of str
+        Names of the components to gather, default: all.
+        The "idcpu" column is always included.
+    only_valid : bool
+        Skip invalid particles, i.e., particles marked for removal
+
+    Returns
+    -------
+    On root, a dict of component names to 1D NumPy arrays, named as in to_df.
+    Use pyarrow.table(columns) for an Arrow table.
+    On all other ranks, None.
+    """
+    from inspect import getmodule
+
+    amr = getmodule(self)
+
+    columns = _named_columns(
+        self,
+        comps,
+        lambda real_comps, int_comps: self._gather_to_root(
+            root, level, real_comps, int_comps, only_valid
+        ),
+    )
+
+    if amr.ParallelDescriptor.MyProc() != root:
+        return None
+    return columns
+
+
+def pc_histogram(
+    self, comps, bins=10, ranges=None, weights=None, level=None, local=False, root=0
+):
+    """
+    Histogram of particle components, computed in C++ without copying particles
+
+    Per-thread histograms are accumulated over all tiles with OpenMP and
+    summed over all MPI ranks on root with one MPI_Reduce. Invalid particles
+    are skipped. Call on all MPI ranks, unless local is True.
+
+    Parameters
+    ----------
+    self : amrex.ParticleContainer_*
+        A ParticleContainer class in pyAMReX
+    comps : str or list of str
+        Names of the Real components, one per histogram dimension,
+        e.g., "x" or ["x", "px"] for a phase space
+    bins : int or list of int
+        Number of bins, per dimension
+    ranges : list of (float, float)
+        (lower, upper) edges per dimension, default: the global min and max.
+        Samples outside of the ranges are ignored.
+    weights : str
+        Name of the Real component to weight particles with, default: count particles
+    level : int
+        Use particles of this mesh-refinement level only, default: all levels
+    local : bool
+        MPI rank-local particles only, returned on all ranks
+    root : int
+        MPI rank to sum the histogram on
+
+    Returns
+    -------
+    As numpy.histogramdd, a tuple of the (float) histogram and a list of bin
+    edges per dimension. For a single component, as numpy.histogram, a tuple
+    of the histogram and its bin edges.
+    If local is False, then all ranks but root will return None.
+    """
+    import numpy as np
+
+    single = isinstance(comps, str)
+    if single:
+        comps = [comps]
+        if ranges is not None:
+            ranges = [ranges]
+    ndim = len(comps)
+    if isinstance(bins, int):
+        bins = [bins] * ndim
+
+    hist, ranges_used = self._histogram(
+        [_real_column(self, name) for name in comps],
+        list(bins),
+        [] if ranges is None else [tuple(r) for r in ranges],
+        None if weights is None else _real_column(self, weights),
+        level,
+        local,
+        root,
+    )
+    if hist is None:
+        return None
+
+    edges = [np.linspace(lo, hi, n + 1) for (lo, hi), n in zip(ranges_used, bins)]
+    if single:
+        return hist, edges[0]
+    return hist, edges
+
+
+def pc_moments(self, comps, order=2, weights=None, level=None, local=False):
+    """
+    Weighted mean and covariance of particle components, computed in C++
+
+    The moments are accumulated in one pass over the particles, on the device
+    of GPU builds, with sums shifted by the values of one particle to avoid
+    cancellation. The results of all MPI ranks are merged with the pairwise
+    update of Chan et al. in one all-reduce.
+    Invalid particles are skipped. Call on all MPI ranks, unless local is True.
+
+    Parameters
+    ----------
+    self : amrex.ParticleContainer_*
+        A ParticleContainer class in pyAMReX
+    comps : list of str
+        Names of the Real components, e.g., ["x", "px"] for a phase space
+    order : int
+        1: mean only, 2: mean and covariance
+    weights : str
+        Name of the Real component to weight particles with, default: all particles weigh 1
+    level : int
+        Use particles of this mesh-refinement level only, default: all levels
+    local : bool
+        MPI rank-local particles only
+
+    Returns
+    -------
+    For order 1, a numpy array of the means of the components.
+    For order 2, a tuple of the means and the covariance matrix, normalized by
+    the total weight as numpy.cov(..., aweights=w, bias=True).
+    NaN if there are no particles. The same result is returned on all ranks.
+
+    Examples
+    --------
+    RMS emittance of a beam in x:
+
+    >>> mean, cov = pc.moments(["x", "ux"], weights="w")
+    >>> emittance = np.sqrt(np.linalg.det(cov))
+    """
+    if order not in (1, 2):
+        raise ValueError("moments: order must be 1 or 2")
+    if isinstance(comps, str):
+        comps = [comps]
+
+    _, mean, cov = self._moments(
+        [_real_column(self, name) for name in comps],
+        None if weights is None else _real_column(self, weights),
+        order,
+        level,
+        local,
+    )
+    if order == 1:
+        return mean
+    return mean, cov
+
+
+def _reduce(self, op, what, constants, level, local):
+    """Reduce Real components (list of str) or an expression (str), see pc_reduce_sum"""
+    names, cols = _real_columns(self)
+    if what is None or isinstance(what, str):
+        comps, expr = [], what
+    else:
+        comps, expr = [_real_column(self, name) for name in what], None
+    return self._reduce(op, comps, expr, names, cols, constants or {}, level, local)
+
+
+def pc_reduce_sum(self, what, constants=None, level=None, local=False):
+    """
+    Sum of particle components or of an expression over all valid particles
+
+    Computed with amrex::ReduceSum, on the device of GPU builds, and summed
+    over all MPI ranks. Call on all MPI ranks, unless local is True.
+
+    Parameters
+    ----------
+    self : amrex.ParticleContainer_*
+        A ParticleContainer class in pyAMReX
+    what : str or list of str
+        An amrex::Parser expression over the names of Real components,
+        e.g., "0.5 * m * (ux*ux + uy*uy + uz*uz)", or a list of names of Real components
+    constants : dict
+        Values of further symbols in the expression, e.g., {"m": 9.1e-31}
+    level : int
+        Use particles of this mesh-refinement level only, default: all levels
+    local : bool
+        MPI rank-local particles only
+
+    Returns
+    -------
+    A float for an expression, or a numpy array with one value per component.
+    """
+    return _reduce(self, "sum", what, constants, level, local)
+
+
+def pc_reduce_min(self, what, constants=None, level=None, local=False):
+    """
+    Minimum of particle components or of an expression over all valid particles
+
+    As reduce_sum, with amrex::ReduceMin. Without particles, the result is +inf.
+    """
+    return _reduce(self, "min", what, constants, level, local)
+
+
+def pc_reduce_max(self, what, constants=None, level=None, local=False):
+    """
+    Maximum of particle components or of an expression over all valid particles
+
+    As reduce_sum, with amrex::ReduceMax. Without particles, the result is -inf.
+    """
+    return _reduce(self, "max", what, constants, level, local)
+
+
+def pc_reduce_count(self, where=None, constants=None, level=None, local=False):
+    """
+    Number of valid particles for which an expression is non-zero
+
+    Parameters
+    ----------
+    self : amrex.ParticleContainer_*
+        A ParticleContainer class in pyAMReX
+    where : str
+        An amrex::Parser expression over the names of Real components,
+        e.g., "w < 0", default: count all valid particles
+    constants : dict
+        Values of further symbols in the expression
+    level : int
+        Use particles of this mesh-refinement level only, default: all levels
+    local : bool
+        MPI rank-local particles only
+
+    Returns
+    -------
+    The number of particles, summed over all MPI ranks unless local.
+    """
+    return _reduce(self, "count", where, constants, level, local)
+
+
+def pc_transform(self, expr_map, constants=None, t=0.0, level=None):
+    """
+    Set Real components of all valid particles to math expressions, in place
+
+    Expressions are compiled with amrex::Parser and evaluated per tile in
+    parallel, on the device of GPU builds, without copies of the particles.
+    All expressions see the values before the update, e.g., a rotation
+    {"x": "c*x - s*y", "y": "s*x + c*y"} is applied simultaneously.
+
+    Parameters
+    ----------
+    self : amrex.ParticleContainer_*
+        A ParticleContainer class in pyAMReX
+    expr_map : dict
+        Expressions in the names of Real components and t, per name of the
+        Real component to set, e.g., {"w": "w * exp(-(x^2 + y^2) / s)"}
+    constants : dict
+        Values of further symbols in the expressions, e.g., {"s": 0.1}
+    t : float
+        Value of the symbol t, unless a component is named t
+    level : int
+        Change particles of this mesh-refinement level only, default: all levels
+
+    Setting positions does not redistribute particles; call redistribute()
+    afterwards if particles may leave their tiles.
+    """
+    names, cols = _real_columns(self)
+    constants = dict(constants or {})
+    if "t" not in names:
+        constants.setdefault("t", t)
+
+    self._transform(
+        [_real_column(self, name) for name in expr_map.keys()],
+        list(expr_map.values()),
+        names,
+        cols,
+        constants,
+        level,
+    )
+
+
+def pc_set_component_from_expression(
+    self, comp, expr, constants=None, t=0.0, level=None
+):
+    """
+    Set a Real component of all valid particles to a math expression, in place
+
+    For example, pc.set_component_from_expression("w", "n0 * exp(-x^2 / s)",
+    constants={"n0": 1e20, "s": 0.1}). See transform for details.
+
+    Parameters
+    ----------
+    self : amrex.ParticleContainer_*
+        A ParticleContainer class in pyAMReX
+    comp : str
+        Name of the Real component to set
+    expr : str
+        Expression in the names of Real components and t
+    constants : dict
+        Values of further symbols in the expression
+    t : float
+        Value of the symbol t, unless a component is named t
+    level : int
+        Change particles of this mesh-refinement level only, default: all levels
+    """
+    pc_transform(self, {comp: expr}, constants, t, level)
+
+
+def pc_init_from_density(
+    self,
+    density,
+    ppc,
+    level=0,
+    seed=None,
+    init_data=None,
+    comp=0,
+    weight=None,
+    constants=None,
+):
+    """
+    Add particles per cell where a density is positive
+
+    Each cell with a positive density gets ppc particles at uniformly random
+    positions in the cell. Counting and filling run in C++ per tile, in
+    parallel with OpenMP or on GPU, with parallel random number streams.
+    Works for all particle layouts. No redistribute is needed.
+
+    Parameters
+    ----------
+    self : amrex.ParticleContainer_*
+        A ParticleContainer class in pyAMReX
+    density : amrex.MultiFab or str
+        A cell-centered MultiFab on the BoxArray and DistributionMapping of
+        the level, or an amrex::Parser expression in x, y, z (per dimension),
+        evaluated at cell centers, e.g., "n0 * exp(-(x^2 + y^2) / s)"
+    ppc : int
+        Number of particles per cell
+    level : int
+        Mesh-refinement level to add particles to
+    seed : int
+        Reseed the random number generators, with seed + MPI rank
+    init_data : amrex.ParticleInitType_*
+        Values of the other compile-time components, as in init_random;
+        runtime components are set to zero
+    comp : int
+        Component of the density MultiFab
+    weight : str
+        Name of a Real component to set to density * cell volume / ppc
+    constants : dict
+        Values of further symbols in a density expression
+
+    Returns
+    -------
+    The number of particles added on this MPI rank.
+    """
+    weight_col = None if weight is None else _real_column(self, weight)
+    if isinstance(density, str):
+        return self._init_from_density(
+            density, constants or {}, ppc, init_data, weight_col, level, seed
+        )
+    return self._init_from_density(
+        density, comp, ppc, init_data, weight_col, level, seed
+    )
+
+
+def pc_load_columns(self, path, layout, level=0):
+    """
+    Add particles from a raw, columnar binary file and redistribute them
+
+    The file has no header. It holds the values of all particles for the
+    first column, then for the second column, and so on, each as
+    little-endian values of the column's dtype. The number of particles
+    follows from the file size.
+
+    Each MPI rank memory-maps only its contiguous range of particles of each
+    column, bulk-copies it into a particle tile and adds it to the level;
+    particles are then redistributed. Call on all MPI ranks.
+
+    Parameters
+    ----------
+    self : amrex.ParticleContainer_*
+        A ParticleContainer class in pyAMReX
+    path : str
+        Path to the file
+    layout : list of (str, dtype)
+        Name and dtype of each column, in file order, e.g.,
+        [("x", "f8"), ("y", "f8"), ("z", "f8"), ("w", "f4")].
+        Names are Real or int components, as in to_df, or "idcpu";
+        None skips a column. Positions must be included.
+        Components without a column are zero; without "idcpu", new ids are assigned.
+        Explicitly big-endian dtypes, e.g., ">f8", raise a ValueError.
+    level : int
+        Mesh-refinement level to add particles to
+
+    Returns
+    -------
+    The number of particles read on this MPI rank.
+    """
+    import os
+    from inspect import getmodule
+
+    import numpy as np
+
+    amr = getmodule(self)
+
+    layout = [(name, np.dtype(dtype)) for name, dtype in layout]
+    for name, dtype in layout:
+        if dtype.byteorder == ">":
+            raise ValueError(
+                f"load_columns: column {name} has the big-endian dtype {dtype.str}, "
+                "but the file holds little-endian values"
+            )
+    layout = [(name, dtype.newbyteorder("<")) for name, dtype in layout]
+    row_bytes = sum(dtype.itemsize for _, dtype in layout)
+    file_size = os.path.getsize(path)
+    if row_bytes == 0 or file_size % row_bytes != 0:
+        raise ValueError(
+            f"load_columns: size of {path} ({file_size} bytes) is not a multiple of "
+            f"the layout ({row_bytes} bytes per particle)"
+        )
+    num_particles = file_size // row_bytes
+
+    # split particles evenly over ranks
+    nprocs = amr.ParallelDescriptor.NProcs()
+    rank = amr.ParallelDescriptor.MyProc()
+    start = num_particles * rank // nprocs
+    count = num_particles * (rank + 1) // nprocs - start
+
+    real_names, _ = _real_columns(self)
+    _, int_names = particle_comp_names(self)
+    if not self.is_soa_particle:
+        int_names = int_names + [f"idata_{i}" for i in range(self.num_struct_int)]
+    for name, _ in layout:
+        if name is not None and name != "idcpu" and name not in real_names + int_names:
+            raise KeyError(
+                f"load_columns: unknown component '{name}', "
+                f"Real components are {real_names}, int components are {int_names}"
+            )
+
+    real_cols, int_cols, idcpu = [], [], None
+    offset = 0
+    for name, dtype in layout:
+        column_offset = offset
+        offset += num_particles * dtype.itemsize
+        if name is None:
+            continue
+        if count > 0:
+            column = np.memmap(
+                path,
+                dtype=dtype,
+                mode="r",
+                offset=column_offset + start * dtype.itemsize,
+                shape=(count,),
+            )
+        else:
+            column = np.empty(0, dtype=dtype)
+
+        if name == "idcpu":
+            idcpu = column
+        elif name in int_names:
+            int_cols.append((_int_column(self, name), column))
+        else:
+            real_cols.append((_real_column(self, name), column))
+
+    self._load_columns(level, real_cols, int_cols, idcpu, count)
+    return count
+
+
+def pc_build_id_index(self):
+    """
+    Build a hash map from idcpu to the location of each local particle
+
+    The index is kept for lookup and rebuilt lazily on the next lookup after
+    any method of the container or of its iterators that adds, removes or
+    moves particles, or if lookup finds that particles were moved otherwise.
+    After changing tiles directly, e.g., by resizing a ParticleTile or writing
+    to idcpu, call build_id_index before lookup: particles added this way are
+    not found otherwise.
+
+    Parameters
+    ----------
+    self : amrex.ParticleContainer_*
+        A ParticleContainer class in pyAMReX
+
+    Returns
+    -------
+    An amrex.ParticleIdIndex with the valid particles of this MPI rank.
+    """
+    index = self._build_id_index()
+    _id_indices[self] = index
+    return index
+
+
+def pc_lookup(self, idcpu, comps=None):
+    """
+    Find local particles by idcpu and gather their components
+
+    Requires build_id_index. Particles that are not on this MPI rank are
+    reported as not found.
+
+    Parameters
+    ----------
+    self : amrex.ParticleContainer_*
+        A ParticleContainer class in pyAMReX
+    idcpu : array of uint64
+        Packed ids and cpus, e.g., from to_columns()["idcpu"] or pack_idcpu
+    comps : list of str
+        Names of Real and int components, as in to_df, default: all
+
+    Returns
+    -------
+    A dict of NumPy arrays, one value per idcpu: "found", "level", "grid",
+    "tile" and "index" (-1 if not found), then the components (NaN or 0 if not found).
+    """
+    import numpy as np
+
+    if self not in _id_indices:
+        raise RuntimeError("lookup: call build_id_index first")
+
+    real_names, real_cols = _real_columns(self)
+    _, int_names = particle_comp_names(self)
+    if not self.is_soa_particle:
+        int_names = int_names + [f"idata_{i}" for i in range(self.num_struct_int)]
+    if comps is None:
+        comps = real_names + int_names
+    real_comps = [c for c in comps if c in real_names]
+    int_comps = [c for c in comps if c not in real_names]
+    real_idx = [real_cols[real_names.index(c)] for c in real_comps]
+    int_idx = [_int_column(self, c) for c in int_comps]
+
+    idcpu = np.ascontiguousarray(idcpu, dtype=np.uint64)
+    for _ in range(2):
+        index = _id_indices[self]
+        if index is None:
+            index = self.build_id_index()
+        stale, locs, reals, ints = self._lookup(index, idcpu, real_idx, int_idx)
+        if not stale:
+            break
+        # particles moved since the index was built
+        _id_indices[self] = None
+
+    result = {
+        "found": locs[:, 0] >= 0,
+        "level": locs[:, 0],
+        "grid": locs[:, 1],
+        "tile": locs[:, 2],
+        "index": locs[:, 3],
+    }
+    result.update(zip(real_comps, reals))
+    result.update(zip(int_comps, ints))
+    return result
+
+
+def pc_redistribute_with_stats(
+    self,
+    lev_min=0,
+    lev_max=-1,
+    nGrow=0,
+    local=0,
+    remove_negative=True,
+    classify=False,
+    log=None,
+):
+    """
+    Redistribute particles, as redistribute, and return statistics of the call
+
+    AMReX does not expose timings of the phases of Redistribute (locate,
+    pack, communicate, unpack); only the time of the whole call is measured.
+    Numbers are for this MPI rank; reduce them over ranks as needed.
+
+    Parameters
+    ----------
+    self : amrex.ParticleContainer_*
+        A ParticleContainer class in pyAMReX
+    lev_min, lev_max, nGrow, local, remove_negative :
+        As in redistribute
+    classify : bool
+        Also classify the particles by comparing their locations before and
+        after Redistribute. This builds two hash indices of all particles and
+        costs about as much as Redistribute itself.
+    log : list
+        If given, the statistics are also appended to it, e.g., to collect
+        them over many steps and convert them with pandas.DataFrame(log).
+
+    Returns
+    -------
+    A dict with the particle count "removed" (invalid or outside a
+    non-periodic domain boundary), the seconds spent in "time_redistribute"
+    (AMReX Redistribute) and in "time_stats_overhead" (collecting these
+    statistics). With classify, also the particle counts "kept" (in their
+    tile), "moved_tile" (to another tile of this rank), "sent" (to other
+    ranks) and "received" (from other ranks), and the estimated
+    "bytes_sent" and "bytes_received" of particle data.
+    """
+    stats = self._redistribute_with_stats(
+        lev_min, lev_max, nGrow, local, remove_negative, classify
+    )
+    if log is not None:
+        log.append(stats)
+    return stats
+
+
+# methods that add, remove or move particles, see _invalidates_id_index
+_id_index_mutators = [
+    "add_particles",
+    "add_particles_at_level",
+    "clear_particles",
+    "copy_particles",
+    "define_and_return_particle_tile",
+    "filter",
+    "init_from_ascii_file",
+    "init_from_binary_file",
+    "init_from_binary_meta_file",
+    "init_from_density",
+    "init_one_per_cell",
+    "init_random",
+    "init_random_per_box",
+    "load_columns",
+    "parallel_for_tiles",
+    "redistribute",
+    "redistribute_with_stats",
+    "remove_particles_at_level",
+    "remove_particles_not_at_finestLevel",
+    "resize_data",
+    "restart",
+    "sort_by",
+    "sort_particles_by_bin",
+    "sort_particles_by_cell",
+]
+
+
+def _invalidates_id_index(method):
+    """Wrap a method that changes particles, so that an id index is rebuilt on the next lookup"""
+    import functools
+
+    @functools.wraps(method)
+    def wrapper(self, *args, **kwargs):
+        try:
+            return method(self, *args, **kwargs)
+        finally:
+            if self in _id_indices:
+                _id_indices[self] = None
+
+    return wrapper
+
+
+def _invalidates_all_id_indices(method):
+    """Wrap a method of an iterator that changes particles: its container is not known, so all id indices are rebuilt"""
+    import functools
+
+    @functools.wraps(method)
+    def wrapper(self, *args, **kwargs):
+        try:
+            return method(self, *args, **kwargs)
+        finally:
+            for pc in list(_id_indices.keys()):
+                _id_indices[pc] = None
+
+    return wrapper
+
+
+def _is_world_comm(comm):
+    """Whether an mpi4py communicator has the ranks of MPI_COMM_WORLD, in order"""
+    from mpi4py import MPI
+
+    return MPI.Comm.Compare(comm, MPI.COMM_WORLD) in (MPI.IDENT, MPI.CONGRUENT)
+
+
+def pc_to_df(self, local=True, comm=None, root_rank=0, only_valid=False):
     """
     Copy all particles into a pandas.DataFrame
 
@@ -20,9 +865,14 @@ def pc_to_df(self, local=True, comm=None, root_rank=0):
     local : bool
         MPI rank-local particles only
     comm : MPI Communicator
-        if local is False, this defaults to mpi4py.MPI.COMM_WORLD
+        if local is False, the mpi4py communicator to gather over. By default
+        and for communicators congruent to mpi4py.MPI.COMM_WORLD, particles
+        are gathered with gather_to_root; otherwise, with comm.gather.
     root_rank : MPI root rank to gather to
         if local is False, this defaults to 0
+    only_valid : bool
+        Skip invalid particles, i.e., particles marked for removal.
+        By default, all particles are included.
 
     Returns
     -------
@@ -41,76 +891,78 @@ def pc_to_df(self, local=True, comm=None, root_rank=0):
         if not amr.Config.have_mpi:
             local = True
 
-    # create a DataFrame per particle box and append it to the list of
-    # local DataFrame(s)
-    dfs_local = []
-    for lvl in range(self.finest_level + 1):
-        for pti in self.const_iterator(self, level=lvl):
-            if pti.size == 0:
-                continue
-
-            if self.is_soa_particle:
-                soa_view = pti.soa().to_numpy(copy=True)
-
-                next_df = pd.DataFrame()
-
-                next_df["idcpu"] = soa_view.idcpu
+    # one contiguous column per component of all local or gathered particles
+    if local:
+        columns = self.to_columns(only_valid=only_valid)
+    elif comm is None or _is_world_comm(comm):
+        columns = self.gather_to_root(root_rank, only_valid=only_valid)
+        if columns is None:
+            return None
+    else:
+        import numpy as np
 
-                soa_np_real = soa_view.real
-                for name, array in soa_np_real.items():
-                    next_df[name] = array
+        columns_list = comm.gather(
+            self.to_columns(only_valid=only_valid), root=root_rank
+        )
+        if comm.Get_rank() != root_rank:
+            return None
+        columns = {
+            name: np.concatenate([c[name] for c in columns_list])
+            for name in columns_list[0]
+        }
 
-                soa_np_int = soa_view.int
-                for name, array in soa_np_int.items():
-                    next_df[name] = array
-            else:
-                # AoS
-                aos_np = pti.aos().to_numpy(copy=True)
-                next_df = pd.DataFrame(aos_np)
+    if len(columns["idcpu"]) == 0:
+        df = None if local else pd.DataFrame()
+    else:
+        df = pd.DataFrame(columns, copy=False)
+        df.index.name = "idcpu"
 
-                # SoA
-                soa_view = pti.soa().to_numpy(copy=True)
-                soa_np_real = soa_view.real
-                soa_np_int = soa_view.int
+    return df
 
-                for name, array in soa_np_real.items():
-                    next_df[f"SoA_{name}"] = array
 
-                for name, array in soa_np_int.items():
-                    next_df[f"SoA_{name}"] = array
+def pc_arrow_c_stream(self, requested_schema=None):
+    """
+    Export the local particles as an Arrow stream with one record batch per tile.
 
-            next_df.set_index("idcpu")
-            next_df.index.name = "idcpu"
+    This implements the Arrow PyCapsule interface, e.g., for pyarrow.table(pc),
+    polars.from_arrow(pc) or DuckDB. Batches are exported lazily, when the
+    consumer reads them. On CPU, the SoA columns are zero-copy views; on GPU,
+    they are copied to host. The columns are named as in to_df.
 
-            dfs_local.append(next_df)
+    Parameters
+    ----------
+    self : amrex.ParticleContainer_* or amrex.ParticleTile_*
+        A ParticleContainer or ParticleTile class in pyAMReX
+    requested_schema : PyCapsule, optional
+        Ignored, the columns are exported with their native types.
 
-    # MPI Gather to root rank if requested
-    if local:
-        if len(dfs_local) == 0:
-            df = None
-        else:
-            df = pd.concat(dfs_local)
-    else:
-        from mpi4py import MPI
+    Returns
+    -------
+    A PyCapsule with an ArrowArrayStream.
+    """
+    return self._arrow_c_stream(*particle_comp_names(self))
 
-        if comm is None:
-            comm = MPI.COMM_WORLD
-        rank = comm.Get_rank()
 
-        # a list for each rank's list of DataFrame(s)
-        df_list_list = comm.gather(dfs_local, root=root_rank)
+def ptile_arrow_c_array(self, requested_schema=None):
+    """
+    Export the particles of a tile as an Arrow record batch, e.g., for pyarrow.record_batch(tile).
 
-        if rank == root_rank:
-            flattened_list = [df for sublist in df_list_list for df in sublist]
+    This implements the Arrow PyCapsule interface. On CPU, the SoA columns are
+    zero-copy views; the legacy AoS data and all data on GPU are copied to host.
+    The columns are named as in to_df.
 
-            if len(flattened_list) == 0:
-                df = pd.DataFrame()
-            else:
-                df = pd.concat(flattened_list, ignore_index=True)
-        else:
-            df = None
+    Parameters
+    ----------
+    self : amrex.ParticleTile_*
+        A ParticleTile class in pyAMReX
+    requested_schema : PyCapsule, optional
+        Ignored, the columns are exported with their native types.
 
-    return df
+    Returns
+    -------
+    A tuple of PyCapsules with an ArrowSchema and an ArrowArray.
+    """
+    return self._arrow_c_array(*particle_comp_names(self))
 
 
 def register_ParticleContainer_extension(amr):
@@ -130,6 +982,18 @@ def register_ParticleContainer_extension(amr):
     ):
         ParIter_type.__next__ = next
         ParIter_type.__iter__ = lambda self: self
+        if hasattr(ParIter_type, "remove_if"):
+            ParIter_type.remove_if = _invalidates_all_id_indices(ParIter_type.remove_if)
+
+    # register member functions for every ParticleTile_* type
+    for _, ParticleTile_type in inspect.getmembers(
+        sys.modules[amr.__name__],
+        lambda member: inspect.isclass(member)
+        and member.__module__ == amr.__name__
+        and member.__name__.startswith("ParticleTile_"),
+    ):
+        ParticleTile_type.__arrow_c_array__ = ptile_arrow_c_array
+        ParticleTile_type.__arrow_c_stream__ = pc_arrow_c_stream
 
     # register member functions for every ParticleContainer_* type
     for _, ParticleContainer_type in inspect.getmembers(
@@ -138,4 +1002,30 @@ def register_ParticleContainer_extension(amr):
         and member.__module__ == amr.__name__
         and member.__name__.startswith("ParticleContainer_"),
     ):
+        ParticleContainer_type.to_columns = pc_to_columns
+        ParticleContainer_type.gather_to_root = pc_gather_to_root
+        ParticleContainer_type.histogram = pc_histogram
+        ParticleContainer_type.moments = pc_moments
+        ParticleContainer_type.reduce_sum = pc_reduce_sum
+        ParticleContainer_type.reduce_min = pc_reduce_min
+        ParticleContainer_type.reduce_max = pc_reduce_max
+        ParticleContainer_type.reduce_count = pc_reduce_count
+        ParticleContainer_type.set_component_from_expression = (
+            pc_set_component_from_expression
+        )
+        ParticleContainer_type.transform = pc_transform
+        ParticleContainer_type.init_from_density = pc_init_from_density
+        ParticleContainer_type.load_columns = pc_load_columns
+        ParticleContainer_type.build_id_index = pc_build_id_index
+        ParticleContainer_type.lookup = pc_lookup
+        ParticleContainer_type.redistribute_with_stats = pc_redistribute_with_stats
         ParticleContainer_type.to_df = pc_to_df
+        ParticleContainer_type.__arrow_c_stream__ = pc_arrow_c_stream
+
+        for name in _id_index_mutators:
+            if hasattr(ParticleContainer_type, name):
+                setattr(
+                    ParticleContainer_type,
+                    name,
+                    _invalidates_id_index(getattr(ParticleContainer_type, name)),
+                )
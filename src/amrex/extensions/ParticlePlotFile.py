@@ -0,0 +1,267 @@
+"""
+This file is part of pyAMReX
+
+Copyright 2024 AMReX community
+Authors: Axel Huebl
+License: BSD-3-Clause-LBNL
+"""
+
+import os
+import re
+
+
+def _idcpu_from_id_and_cpu(ids, cpus):
+    """Pack ids and cpus as in amrex::SetParticleIDandCPU"""
+    import numpy as np
+
+    ids = ids.astype(np.int64)
+    idcpu = (np.abs(ids).astype(np.uint64) & np.uint64(0x7FFFFFFFFF)) << np.uint64(24)
+    idcpu |= cpus.astype(np.uint64) & np.uint64(0xFFFFFF)
+    idcpu[ids >= 0] |= np.uint64(1) << np.uint64(63)
+    return idcpu
+
+
+class ParticlePlotFileReader:
+    """
+    Read the particles of an AMReX plotfile or checkpoint without a ParticleContainer
+
+    Parses the particle Header and the Particle_H of each level and
+    memory-maps the DATA_* files. Columns of a grid are views into the files
+    and are only read when accessed. No AMReX initialization is needed.
+
+    Real columns are named "x", "y", "z" (per dimension) followed by the
+    names in the Header; int columns as in the Header. Ids and cpus are in the
+    "idcpu" column, packed as in the pure SoA layout.
+
+    Parameters
+    ----------
+    dir : str
+        The plotfile or checkpoint directory
+    name : str
+        The name of the particle species, as in write_plotfile
+    """
+
+    def __init__(self, dir, name="particles"):
+        import numpy as np
+
+        self.path = os.path.join(dir, name)
+        with open(os.path.join(self.path, "Header")) as f:
+            tokens = iter(f.read().split())
+
+        self.version = next(tokens)
+        if not self.version.startswith("Version_Two_Dot_"):
+            raise ValueError(
+                f"ParticlePlotFileReader: unsupported particle file version '{self.version}'"
+            )
+        if self.version.endswith("_single"):
+            self.real_dtype = np.dtype("=f4")
+        elif self.version.endswith("_double"):
+            self.real_dtype = np.dtype("=f8")
+        else:
+            raise ValueError(
+                f"ParticlePlotFileReader: unknown precision of version '{self.version}'"
+            )
+
+        self.spacedim = int(next(tokens))
+        num_real = int(next(tokens))
+        self.real_comp_names = ["x", "y", "z"][: self.spacedim] + [
+            next(tokens) for _ in range(num_real)
+        ]
+        num_int = int(next(tokens))
+        self.int_comp_names = [next(tokens) for _ in range(num_int)]
+        self.has_ids = bool(int(next(tokens)))
+        self.num_particles = int(next(tokens))
+        self.next_id = int(next(tokens))
+        self.finest_level = int(next(tokens))
+        num_grids = [int(next(tokens)) for _ in range(self.finest_level + 1)]
+
+        # (file number, particle count, byte offset) per grid and level
+        self.grids = [
+            [
+                (int(next(tokens)), int(next(tokens)), int(next(tokens)))
+                for _ in range(num_grids[lev])
+            ]
+            for lev in range(self.finest_level + 1)
+        ]
+
+        self._int_chunk = (2 if self.has_ids else 0) + num_int
+        self._real_chunk = len(self.real_comp_names)
+        self._files = {}
+
+    def num_grids(self, level=0):
+        """Number of grids on a level"""
+        return len(self.grids[level])
+
+    def num_particles_at(self, level=0, grid=None):
+        """Number of particles of a grid, or of all grids of a level"""
+        if grid is None:
+            return sum(count for _, count, _ in self.grids[level])
+        return self.grids[level][grid][1]
+
+    def boxes(self, level=0):
+        """
+        Grids of a level, as in the BoxArray of the ParticleContainer
+
+        Returns
+        -------
+        A list of (small_end, big_end) tuples of cell indices.
+        """
+        with open(os.path.join(self.path, f"Level_{level}", "Particle_H")) as f:
+            text = f.read()
+        return [
+            (
+                tuple(int(v) for v in lo.split(",")),
+                tuple(int(v) for v in hi.split(",")),
+            )
+            for lo, hi in re.findall(r"\(\(([^)]*)\)\s*\(([^)]*)\)\s*\([^)]*\)\)", text)
+        ]
+
+    def _file(self, level, which):
+        """Memory-map of a DATA_* file as bytes, cached"""
+        import numpy as np
+
+        key = (level, which)
+        if key not in self._files:
+            path = os.path.join(self.path, f"Level_{level}", f"DATA_{which:05d}")
+            self._files[key] = np.memmap(path, dtype=np.uint8, mode="r")
+        return self._files[key]
+
+    def _check_comps(self, comps):
+        names = ["idcpu"] if self.has_ids else []
+        names += self.real_comp_names + self.int_comp_names
+        if comps is None:
+            return names
+        for comp in comps:
+            if comp not in names:
+                raise KeyError(f"ParticlePlotFileReader: unknown component '{comp}'")
+        return list(comps)
+
+    def _dtype(self, comp):
+        import numpy as np
+
+        if comp == "idcpu":
+            return np.dtype(np.uint64)
+        if comp in self.real_comp_names:
+            return self.real_dtype
+        return np.dtype("=i4")
+
+    def grid_columns(self, level=0, grid=0, comps=None):
+        """
+        Columns of the particles of one grid
+
+        Parameters
+        ----------
+        level : int
+            Mesh-refinement level
+        grid : int
+            Index of the grid in the BoxArray of the level
+        comps : list of str
+            Names of the columns, default: all
+
+        Returns
+        -------
+        A dict of NumPy arrays. Real and int columns are strided, read-only
+        views into the memory-mapped file; "idcpu" is computed.
+        """
+        import numpy as np
+
+        comps = self._check_comps(comps)
+        which, count, where = self.grids[level][grid]
+        if count == 0:
+            return {comp: np.empty(0, dtype=self._dtype(comp)) for comp in comps}
+
+        data = self._file(level, which)
+        int_bytes = count * self._int_chunk * 4
+        real_bytes = count * self._real_chunk * self.real_dtype.itemsize
+        ints = (
+            data[where : where + int_bytes].view("=i4").reshape(count, self._int_chunk)
+        )
+        reals = (
+            data[where + int_bytes : where + int_bytes + real_bytes]
+            .view(self.real_dtype)
+            .reshape(count, self._real_chunk)
+        )
+
+        first_int = 2 if self.has_ids else 0
+        columns = {}
+        for comp in comps:
+            if comp == "idcpu":
+                if self.version.startswith("Version_Two_Dot_One"):
+                    # the upper and lower 32 bits of idcpu
+                    halves = ints[:, :2].astype(np.int64) & 0xFFFFFFFF
+                    columns[comp] = (
+                        halves[:, 0].astype(np.uint64) << np.uint64(32)
+                    ) | (halves[:, 1].astype(np.uint64))
+                else:
+                    columns[comp] = _idcpu_from_id_and_cpu(ints[:, 0], ints[:, 1])
+            elif comp in self.real_comp_names:
+                columns[comp] = reals[:, self.real_comp_names.index(comp)]
+            else:
+                columns[comp] = ints[:, first_int + self.int_comp_names.index(comp)]
+        return columns
+
+    def columns(self, comps=None, level=None, grids=None, max_workers=None):
+        """
+        Contiguous columns of the particles of many grids
+
+        Grids are read in parallel, with one thread per grid up to max_workers.
+
+        Parameters
+        ----------
+        comps : list of str
+            Names of the columns, default: all
+        level : int
+            Mesh-refinement level, default: all levels
+        grids : list of int
+            Indices of the grids of the level, default: all; requires level
+        max_workers : int
+            Maximum number of reading threads, default as in concurrent.futures
+
+        Returns
+        -------
+        A dict of NumPy arrays, in the order of levels and grids.
+        """
+        from concurrent.futures import ThreadPoolExecutor
+
+        import numpy as np
+
+        comps = self._check_comps(comps)
+        if grids is not None and level is None:
+            raise ValueError("ParticlePlotFileReader: grids requires a level")
+        levels = range(self.finest_level + 1) if level is None else [level]
+        items = [
+            (lev, grid)
+            for lev in levels
+            for grid in (range(self.num_grids(lev)) if grids is None else grids)
+        ]
+
+        offsets = np.cumsum([0] + [self.num_particles_at(*item) for item in items])
+        out = {comp: np.empty(offsets[-1], dtype=self._dtype(comp)) for comp in comps}
+
+        def read(k):
+            lev, grid = items[k]
+            if offsets[k + 1] == offsets[k]:
+                return
+            for comp, column in self.grid_columns(lev, grid, comps).items():
+                out[comp][offsets[k] : offsets[k + 1]] = column
+
+        with ThreadPoolExecutor(max_workers=max_workers) as pool:
+            list(pool.map(read, range(len(items))))
+        return out
+
+    def to_df(self, comps=None, level=None, max_workers=None):
+        """
+        Copy particles into a pandas.DataFrame, indexed by idcpu if read
+
+        Parameters
+        ----------
+        comps, level, max_workers :
+            As in columns
+        """
+        import pandas as pd
+
+        columns = self.columns(comps, level=level, max_workers=max_workers)
+        df = pd.DataFrame(columns)
+        if "idcpu" in df:
+            df = df.set_index("idcpu")
+        return df
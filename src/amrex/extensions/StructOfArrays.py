@@ -214,6 +214,68 @@ def soa_to_xp(self, copy=False):
     return self.to_cupy(copy) if amr.Config.have_gpu else self.to_numpy(copy)
 
 
+def soa_comp_names(self):
+    """
+    Names of the Real and int components, as in to_numpy.
+
+    Parameters
+    ----------
+    self : amrex.StructOfArrays_*
+        A StructOfArrays class in pyAMReX
+
+    Returns
+    -------
+    A tuple of the lists of Real and int component names.
+    """
+    # for the legacy data layout, do not start with x, y, z but with a, b, c, ...
+    real_comp_names = soa_real_comps(self, self.num_real_comps, rotate=self.has_idcpu)
+    int_comp_names = soa_int_comps(self, self.num_int_comps)
+    return real_comp_names, int_comp_names
+
+
+def soa_arrow_c_array(self, requested_schema=None):
+    """
+    Export the particles as an Arrow record batch, e.g., for pyarrow.record_batch(soa).
+
+    This implements the Arrow PyCapsule interface. On CPU, columns are
+    zero-copy views into the SoA components; on GPU, they are copied to host.
+
+    Parameters
+    ----------
+    self : amrex.StructOfArrays_*
+        A StructOfArrays class in pyAMReX
+    requested_schema : PyCapsule, optional
+        Ignored, the columns are exported with their native types.
+
+    Returns
+    -------
+    A tuple of PyCapsules with an ArrowSchema and an ArrowArray.
+    The columns are idcpu (pure SoA layout only), then all Real and int
+    components, named as in to_numpy.
+    """
+    return self._arrow_c_array(*soa_comp_names(self))
+
+
+def soa_arrow_c_stream(self, requested_schema=None):
+    """
+    Export the particles as an Arrow stream with one record batch, e.g., for pyarrow.table(soa).
+
+    See __arrow_c_array__ for the columns.
+
+    Parameters
+    ----------
+    self : amrex.StructOfArrays_*
+        A StructOfArrays class in pyAMReX
+    requested_schema : PyCapsule, optional
+        Ignored, the columns are exported with their native types.
+
+    Returns
+    -------
+    A PyCapsule with an ArrowArrayStream.
+    """
+    return self._arrow_c_stream(*soa_comp_names(self))
+
+
 def register_SoA_extension(amr):
     """StructOfArrays helper methods"""
     import inspect
@@ -234,3 +296,7 @@ def register_SoA_extension(amr):
         SoA_type.to_numpy = soa_to_numpy
         SoA_type.to_cupy = soa_to_cupy
         SoA_type.to_xp = soa_to_xp
+
+        # Arrow PyCapsule interface
+        SoA_type.__arrow_c_array__ = soa_arrow_c_array
+        SoA_type.__arrow_c_stream__ = soa_arrow_c_stream
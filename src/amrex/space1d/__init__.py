@@ -47,8 +47,10 @@ def Print(*args, **kwargs):
 
 from ..extensions.Array4 import register_Array4_extension
 from ..extensions.ArrayOfStructs import register_AoS_extension
+from ..extensions.AsyncWriter import AsyncWriter  # noqa
 from ..extensions.MultiFab import register_MultiFab_extension
 from ..extensions.ParticleContainer import register_ParticleContainer_extension
+from ..extensions.ParticlePlotFile import ParticlePlotFileReader  # noqa
 from ..extensions.PODVector import register_PODVector_extension
 from ..extensions.StructOfArrays import register_SoA_extension
 
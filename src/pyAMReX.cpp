@@ -31,6 +31,7 @@ void init_AmrMesh(py::module &);
 void init_MultiFab(py::module &);
 void init_ParallelDescriptor(py::module &);
 void init_ParmParse(py::module &);
+void init_Parser(py::module &);
 void init_ParticleContainer(py::module &);
 void init_Periodicity(py::module &);
 void init_PlotFileUtil(py::module &);
@@ -74,6 +75,7 @@ PYBIND11_MODULE(amrex_3d_pybind, m) {
                ParallelDescriptor
                Particle
                ParmParse
+               Parser
                ParticleTile
                ParticleContainer
                Periodicity
@@ -96,6 +98,7 @@ PYBIND11_MODULE(amrex_3d_pybind, m) {
     init_Array4(m);
     init_BoxArray(m);
     init_ParmParse(m);
+    init_Parser(m);
     init_CoordSys(m);
     init_RealBox(m);
     init_Vector(m);
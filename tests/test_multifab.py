@@ -1,5 +1,6 @@
 # -*- coding: utf-8 -*-
 
+import importlib
 import math
 
 import numpy as np
@@ -191,6 +192,75 @@ def test_mfab_simple(mfab):
         np.testing.assert_allclose(mfab.min(i), 1.0 / (20.0 + (10 * (i + 1))))
 
 
+def test_mfab_histogram(boxarr, distmap):
+    mfab = amr.MultiFab(boxarr, distmap, 2, 1)
+    mfab.set_val(-1.0)
+    mfab.set_val(0.25, 0, 1)
+    mfab.set_val(0.75, 1, 1)
+
+    # ghost cells (-1.0) are outside of the range and not counted anyway
+    result = mfab.histogram(1, bins=4, range=(0.0, 1.0))
+    if amr.ParallelDescriptor.MyProc() == 0:
+        hist, edges = result
+        assert np.allclose(edges, [0.0, 0.25, 0.5, 0.75, 1.0])
+        assert np.array_equal(hist, [0, 0, 0, boxarr.numPts])
+    else:
+        assert result is None
+
+    hist, _ = mfab.histogram(0, bins=2, local=True)
+    assert hist.sum() == sum(mfi.validbox().num_pts for mfi in mfab)
+
+
+def test_mfab_fill_from_expression(boxarr, distmap, std_geometry):
+    mfab = amr.MultiFab(boxarr, distmap, 2, 1)
+    mfab.set_val(-1.0)
+    dx = 1.0 / 64
+
+    # cell centers of the valid cells, with constants
+    mfab.fill_from_expression(
+        "2*x + c*t", std_geometry, comp=1, t=0.5, constants={"c": 3.0}
+    )
+    np.testing.assert_allclose(mfab.min(1), 2 * 0.5 * dx + 1.5)
+    np.testing.assert_allclose(mfab.max(1), 2 * 63.5 * dx + 1.5)
+    assert mfab.min(0) == -1.0
+    assert mfab.min(comp=1, nghost=1) == -1.0
+
+    # a pre-compiled Parser, also callable on host
+    parser = amr.Parser("x*y + t", ["x", "y", "z", "t"])
+    assert parser.symbols == {"x", "y", "t"}
+    assert parser(0.5, 2.0, 0.0, 1.0) == 2.0
+    mfab.fill_from_expression(parser, std_geometry, comp=0, t=1.0, ngrow=1)
+    np.testing.assert_allclose(mfab.max(0), (63.5 * dx) ** 2 + 1.0)
+    np.testing.assert_allclose(mfab.max(comp=0, nghost=1), (64.5 * dx) ** 2 + 1.0)
+
+    with pytest.raises(Exception):
+        mfab.fill_from_expression("x + unknown", std_geometry)
+
+    # ngrow is keyword-only in both overloads
+    for expr in ["x", parser]:
+        with pytest.raises(TypeError):
+            mfab.fill_from_expression(expr, std_geometry, 0, 0.0, 1)
+        mfab.fill_from_expression(expr, std_geometry, 0, 0.0, ngrow=1)
+
+
+@pytest.mark.skipif(
+    importlib.util.find_spec("pyarrow") is None, reason="pyarrow is not available"
+)
+def test_mfab_arrow(boxarr, distmap):
+    import pyarrow as pa
+
+    mfab = amr.MultiFab(boxarr, distmap, 2, 0)
+    mfab.set_val(3.0, 0, 1)
+    mfab.set_val(4.0, 1, 1)
+
+    # one record batch per local box
+    table = pa.table(mfab)
+    assert table.column_names == ["comp_0", "comp_1"]
+    assert table.num_rows == sum(mfi.fabbox().num_pts for mfi in mfab)
+    assert np.all(table["comp_0"].to_numpy() == 3.0)
+    assert np.all(table["comp_1"].to_numpy() == 4.0)
+
+
 @pytest.mark.parametrize("nghost", [0, 1])
 def test_mfab_ops(boxarr, distmap, nghost):
     src = amr.MultiFab(boxarr, distmap, 3, nghost)
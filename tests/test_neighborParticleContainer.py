@@ -0,0 +1,59 @@
+# -*- coding: utf-8 -*-
+
+import numpy as np
+import pytest
+
+import amrex.space3d as amr
+
+
+@pytest.fixture(scope="function")
+def neighbor_particle_container():
+    bx = amr.Box(amr.IntVect(0, 0, 0), amr.IntVect(15, 15, 15))
+    rb = amr.RealBox(0, 0, 0, 1.0, 1.0, 1.0)
+    gm = amr.Geometry(bx, rb, 0, [0, 0, 0])
+    ba = amr.BoxArray(bx)
+    ba.max_size(8)
+    dm = amr.DistributionMapping(ba)
+
+    pc = amr.NeighborParticleContainer_2_1_3_1_default(gm, dm, ba, 1)
+
+    myt = amr.ParticleInitType_2_1_3_1()
+    myt.real_struct_data = [0.5, 0.6]
+    myt.int_struct_data = [5]
+    myt.real_array_data = [0.5, 0.2, 0.3]
+    myt.int_array_data = [1]
+    pc.init_random(500, 1, myt, False, rb)
+
+    return pc
+
+
+@pytest.mark.skipif(amr.Config.have_gpu, reason="Host-side neighbor list check")
+def test_neighbor_list(neighbor_particle_container):
+    pc = neighbor_particle_container
+    cutoff = 1.0 / 16
+
+    pc.fill_neighbors()
+    pc.build_neighbor_list(cutoff)
+
+    for (grid, tile), pt in pc.get_particles(0).items():
+        np_real = pt.num_real_particles
+        if np_real == 0:
+            continue
+
+        aos = pt.get_array_of_structs().to_numpy()
+        pos = np.stack([aos["x"], aos["y"], aos["z"]], axis=-1)
+
+        offsets = pc.neighbor_list_offsets(0, grid, tile).to_numpy()
+        indices = pc.neighbor_list_indices(0, grid, tile).to_numpy()
+        assert len(offsets) >= np_real + 1
+
+        for i in range(np_real):
+            nbors = indices[offsets[i] : offsets[i + 1]]
+            dist = np.linalg.norm(pos - pos[i], axis=-1)
+            expected = np.flatnonzero(dist <= cutoff)
+            expected = expected[expected != i]
+            assert sorted(nbors) == sorted(expected)
+
+    pc.clear_neighbors()
+    for pt in pc.get_particles(0).values():
+        assert pt.num_neighbor_particles == 0
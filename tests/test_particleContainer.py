@@ -1,6 +1,8 @@
 # -*- coding: utf-8 -*-
 
+import ctypes
 import importlib
+import itertools
 
 import numpy as np
 import pytest
@@ -553,3 +555,934 @@ def test_pc_df_mpi(particle_container, Npart):
         print(df)
 
         assert len(df.columns) == 14
+
+    # a sub-communicator: gather over its ranks only
+    from mpi4py import MPI
+
+    world = MPI.COMM_WORLD
+    sub = world.Split(world.Get_rank() % 2, world.Get_rank())
+    np_sub = sub.allreduce(pc.total_number_of_particles(False, True))
+    df = pc.to_df(local=False, comm=sub)
+    if sub.Get_rank() == 0:
+        assert len(df) == np_sub
+    else:
+        assert df is None
+    sub.Free()
+
+
+@pytest.mark.skipif(
+    importlib.util.find_spec("pandas") is None, reason="pandas is not available"
+)
+def test_pc_df_invalid(soa_particle_container):
+    pc = soa_particle_container
+    np_local = pc.total_number_of_particles(False, True)
+
+    # mark one local particle invalid: invalid particles are kept by default
+    for pti in pc.iterator(pc, level=0):
+        if pti.size > 0:
+            pti.soa().get_idcpu_data().to_numpy()[0] = 0
+            break
+    df = pc.to_df()
+    if np_local > 1:
+        assert len(df) == np_local
+        assert len(pc.to_df(only_valid=True)) == np_local - 1
+
+
+def test_pc_to_columns(particle_container, soa_particle_container, Npart):
+    # legacy layout: AoS columns, then SoA columns as in to_df
+    pc = particle_container
+    columns = pc.to_columns()
+    assert len(columns) == 14
+    np_local = pc.total_number_of_particles(True, True)
+    for array in columns.values():
+        assert array.shape == (np_local,)
+
+    aos_x = np.concatenate(
+        [
+            pti.aos().to_numpy(copy=True)["x"]
+            for lvl in range(pc.finest_level + 1)
+            for pti in pc.iterator(pc, level=lvl)
+        ]
+    )
+    assert np.array_equal(columns["x"], aos_x)
+
+    # pure SoA layout: select components
+    pc = soa_particle_container
+    columns = pc.to_columns(level=0, comps=["x", "i0"])
+    assert list(columns.keys()) == ["idcpu", "x", "i0"]
+    assert columns["x"].shape == (pc.total_number_of_particles(True, True),)
+    assert np.all(columns["i0"] == 42)
+
+
+def test_pc_gather_to_root(particle_container, Npart):
+    pc = particle_container
+    np_total = pc.total_number_of_particles()
+
+    columns = pc.gather_to_root(0, comps=["x", "y", "z", "SoA_a"])
+    if amr.ParallelDescriptor.MyProc() == 0:
+        assert list(columns.keys()) == ["x", "y", "z", "idcpu", "SoA_a"]
+        for array in columns.values():
+            assert array.shape == (np_total,)
+        # every particle exactly once
+        assert len(np.unique(columns["idcpu"])) == np_total
+    else:
+        assert columns is None
+
+
+def test_pc_histogram(particle_container, soa_particle_container, Npart):
+    # 1D, local, compared to NumPy
+    pc = soa_particle_container
+    columns = pc.to_columns()
+    hist, edges = pc.histogram("x", bins=8, ranges=(0.0, 1.0), local=True)
+    np_hist, np_edges = np.histogram(columns["x"], bins=8, range=(0.0, 1.0))
+    assert np.array_equal(hist, np_hist)
+    assert np.allclose(edges, np_edges)
+
+    # 2D phase space with weights, summed on root
+    pc = particle_container
+    result = pc.histogram(["x", "y"], bins=[4, 5], weights="SoA_a")
+    if amr.ParallelDescriptor.MyProc() == 0:
+        hist, edges = result
+        assert hist.shape == (4, 5)
+        assert len(edges) == 2 and len(edges[1]) == 6
+        # all particles are inside the auto ranges, SoA_a is 0.5
+        assert np.isclose(hist.sum(), 0.5 * pc.total_number_of_particles())
+    else:
+        assert result is None
+
+
+def test_pc_moments(particle_container, soa_particle_container, Npart):
+    # local, compared to NumPy
+    pc = soa_particle_container
+    columns = pc.to_columns()
+    samples = np.vstack([columns["x"], columns["y"], columns["z"]])
+    mean = pc.moments(["x", "y", "z"], order=1, local=True)
+    assert np.allclose(mean, samples.mean(axis=1))
+    mean, cov = pc.moments(["x", "y", "z"], local=True)
+    assert cov.shape == (3, 3)
+    assert np.allclose(cov, np.cov(samples, bias=True))
+
+    # a large offset does not cancel the variance
+    for pti in pc.iterator(pc, level=0):
+        real = pti.soa().to_numpy().real
+        real["a"][:] = 1.0e8 + real["x"]
+    a = pc.to_columns(comps=["a"])["a"].astype(np.float64)
+    _, cov_a = pc.moments(["a"], local=True)
+    assert np.isclose(cov_a[0, 0], np.var(a), rtol=1e-6)
+
+    # weighted, over all ranks: a constant weight does not change the moments
+    pc = particle_container
+    mean_w, cov_w = pc.moments(["x", "y"], weights="SoA_a")
+    mean, cov = pc.moments(["x", "y"])
+    assert np.allclose(mean_w, mean)
+    assert np.allclose(cov_w, cov)
+    assert np.allclose(cov, cov.T)
+
+
+def test_pc_reduce(particle_container, soa_particle_container, Npart):
+    # local, compared to NumPy
+    pc = soa_particle_container
+    columns = pc.to_columns()
+    sums = pc.reduce_sum(["x", "y"], local=True)
+    assert np.allclose(sums, [columns["x"].sum(), columns["y"].sum()])
+    assert np.isclose(pc.reduce_min("x", local=True), columns["x"].min())
+    assert np.isclose(
+        pc.reduce_max("sqrt(x*x + y*y)", local=True),
+        np.sqrt(columns["x"] ** 2 + columns["y"] ** 2).max(),
+    )
+    assert pc.reduce_count("x < 0.5", local=True) == np.count_nonzero(
+        columns["x"] < 0.5
+    )
+
+    # over all ranks, with constants and AoS positions of the legacy layout
+    pc = particle_container
+    num_particles = pc.total_number_of_particles()
+    assert pc.reduce_count() == num_particles
+    assert np.isclose(
+        pc.reduce_sum("c * SoA_a", constants={"c": 2.0}), 2.0 * 0.5 * num_particles
+    )
+    assert pc.reduce_count("x >= 0") == num_particles
+
+    with pytest.raises(Exception):
+        pc.reduce_sum("unknown_comp")
+
+
+def test_pc_transform(particle_container, soa_particle_container, Npart):
+    # pure SoA: set a component, then swap two components simultaneously
+    pc = soa_particle_container
+    before = pc.to_columns()
+    pc.set_component_from_expression("a", "c * x + t", constants={"c": 2.0}, t=1.0)
+    pc.transform({"x": "y", "y": "x"})
+    after = pc.to_columns()
+    assert np.allclose(after["a"], 2.0 * before["x"] + 1.0)
+    assert np.array_equal(after["x"], before["y"])
+    assert np.array_equal(after["y"], before["x"])
+
+    # legacy layout: SoA and AoS components
+    pc = particle_container
+    pc.transform({"SoA_a": "SoA_a + rdata_0", "rdata_1": "2 * rdata_1"})
+    columns = pc.to_columns()
+    assert np.allclose(columns["SoA_a"], 0.5 + 0.5)
+    assert np.allclose(columns["rdata_1"], 1.2)
+
+    with pytest.raises(Exception):
+        pc.set_component_from_expression("SoA_a", "unknown_comp")
+
+
+def test_pc_init_from_density(std_geometry, distmap, boxarr):
+    # pure SoA, from an expression: particles in the lower half in x only
+    pc = amr.ParticleContainer_pureSoA_8_0_default(std_geometry, distmap, boxarr)
+    n_local = pc.init_from_density(
+        "n0 * (x < 0.5)", ppc=2, seed=42, weight="b", constants={"n0": 3.0}
+    )
+    assert n_local == pc.number_of_particles_at_level(0, True, True)
+    assert pc.total_number_of_particles() == 2 * 32 * 64 * 64
+    columns = pc.to_columns()
+    assert np.all(columns["x"] < 0.5)
+    assert np.allclose(columns["b"], 3.0 / 64**3 / 2)
+    assert len(np.unique(columns["idcpu"])) == n_local
+
+    # legacy layout, from a MultiFab
+    pc = amr.ParticleContainer_2_1_3_1_default(std_geometry, distmap, boxarr)
+    density = amr.MultiFab(boxarr, distmap, 1, 0)
+    density.set_val(1.0)
+    myt = amr.ParticleInitType_2_1_3_1()
+    myt.real_struct_data = [0.5, 0.6]
+    myt.int_struct_data = [5]
+    myt.real_array_data = [0.5, 0.2, 0.3]
+    myt.int_array_data = [1]
+    pc.init_from_density(density, ppc=1, init_data=myt)
+    assert pc.total_number_of_particles() == 64**3
+    columns = pc.to_columns()
+    assert np.all(columns["rdata_1"] == 0.6)
+    assert np.all(columns["SoA_a"] == 0.5)
+
+
+def test_pc_load_columns(tmp_path_factory, std_geometry, distmap, boxarr):
+    # write a raw columnar file with x, y, z, a (float32) and i0 (int32)
+    num_particles = 1000
+    rng = np.random.default_rng(seed=1)
+    pos = rng.random((3, num_particles))
+    a = np.arange(num_particles, dtype="<f4")
+    i0 = np.arange(num_particles, dtype="<i4")
+
+    path = None
+    if amr.ParallelDescriptor.MyProc() == 0:
+        path = tmp_path_factory.mktemp("load_columns") / "particles.bin"
+        with open(path, "wb") as f:
+            f.write(pos.astype("<f8").tobytes())
+            f.write(a.tobytes())
+            f.write(i0.tobytes())
+    if amr.Config.have_mpi:
+        from mpi4py import MPI
+
+        path = MPI.COMM_WORLD.bcast(path, root=0)
+
+    pc = amr.ParticleContainer_pureSoA_8_0_default(std_geometry, distmap, boxarr)
+    pc.add_int_comp(True)
+    layout = [("x", "f8"), ("y", "f8"), ("z", "f8"), ("a", "f4"), ("i0", "i4")]
+    with pytest.raises(KeyError):
+        pc.load_columns(str(path), layout[:4] + [("i1", "i4")])
+    with pytest.raises(ValueError):
+        pc.load_columns(str(path), [("x", ">f8")] + layout[1:])
+    pc.load_columns(str(path), layout)
+    assert pc.total_number_of_particles() == num_particles
+
+    columns = pc.gather_to_root()
+    if amr.ParallelDescriptor.MyProc() == 0:
+        order = np.argsort(columns["i0"])
+        assert np.array_equal(columns["i0"][order], i0)
+        assert np.allclose(columns["a"][order], a)
+        assert np.allclose(columns["x"][order], pos[0])
+        assert np.all(columns["b"] == 0.0)
+
+
+def test_pc_write_plotfile_checkpoint(
+    tmp_path_factory, soa_particle_container, std_geometry, distmap, boxarr
+):
+    pc = soa_particle_container
+
+    path = None
+    if amr.ParallelDescriptor.MyProc() == 0:
+        path = str(tmp_path_factory.mktemp("particle_io"))
+    if amr.Config.have_mpi:
+        from mpi4py import MPI
+
+        path = MPI.COMM_WORLD.bcast(path, root=0)
+
+    # 6 Real components (without positions) and 2 int components
+    real_names = ["a", "b", "c", "d", "e", "f"]
+    int_names = ["i0", "i1"]
+    pc.write_plotfile(
+        path + "/plt",
+        "particles",
+        write_real_comp=[1, 0, 0, 0, 0, 1],
+        write_int_comp=[0, 1],
+        real_comp_names=real_names,
+        int_comp_names=int_names,
+    )
+    with pytest.raises(RuntimeError):
+        pc.write_plotfile(path + "/plt_bad", "particles", write_real_comp=[1, 0])
+
+    pc.checkpoint(path + "/chk", "particles", real_names, int_names)
+    if amr.Config.have_mpi:
+        MPI.COMM_WORLD.Barrier()
+
+    if amr.ParallelDescriptor.MyProc() == 0:
+        header = open(path + "/plt/particles/Header").read().split()
+        assert header[2:5] == ["2", "a", "f"]
+        assert header[5:7] == ["1", "i1"]
+
+    pc_restart = amr.ParticleContainer_pureSoA_8_0_default(
+        std_geometry, distmap, boxarr
+    )
+    pc_restart.add_real_comp(True)
+    pc_restart.add_int_comp(True)
+    pc_restart.add_int_comp(True)
+    pc_restart.restart_checkpoint(path + "/chk", "particles", True)
+    assert pc_restart.total_number_of_particles() == pc.total_number_of_particles()
+    assert pc_restart.reduce_sum("f") == pytest.approx(pc.reduce_sum("f"))
+
+
+def test_pc_redistribute_with_stats(soa_particle_container, Npart):
+    pc = soa_particle_container
+
+    def total(stats, key):
+        if amr.Config.have_mpi:
+            from mpi4py import MPI
+
+            return MPI.COMM_WORLD.allreduce(stats[key])
+        return stats[key]
+
+    # without classification: counts and timings only
+    stats = pc.redistribute_with_stats()
+    assert "kept" not in stats
+    assert total(stats, "removed") == 0
+    assert stats["time_stats_overhead"] >= 0.0
+
+    # particles are in place
+    log = []
+    stats = pc.redistribute_with_stats(classify=True, log=log)
+    assert total(stats, "kept") == Npart
+    assert total(stats, "moved_tile") + total(stats, "sent") == 0
+    assert total(stats, "removed") == 0
+    assert stats["time_redistribute"] >= 0.0
+
+    # leave the non-periodic domain in x, cross grids in periodic z
+    n_out = pc.reduce_count("x >= 0.5")
+    pc.transform({"x": "x + 0.5", "z": "z + 0.5"})
+    stats = pc.redistribute_with_stats(classify=True, log=log)
+    assert len(log) == 2 and log[1] is stats
+    assert total(stats, "removed") == n_out
+    assert total(stats, "kept") == 0
+    assert total(stats, "moved_tile") + total(stats, "sent") == Npart - n_out
+    assert total(stats, "sent") == total(stats, "received")
+    assert stats["bytes_sent"] >= stats["sent"]
+    assert pc.total_number_of_particles() == Npart - n_out
+
+
+def test_pc_id_index(
+    particle_container, soa_particle_container, std_geometry, distmap, boxarr
+):
+    for pc, int_name in [
+        (particle_container, "SoA_i2"),
+        (soa_particle_container, "i1"),
+    ]:
+        with pytest.raises(RuntimeError):
+            pc.lookup(np.zeros(1, dtype=np.uint64))
+
+        index = pc.build_id_index()
+        columns = pc.to_columns()
+        assert len(index) == len(columns["idcpu"])
+
+        idcpu = np.append(columns["idcpu"][::7], np.uint64(0))
+        if len(idcpu) > 1:
+            assert int(idcpu[0]) in index
+            assert index.location(int(idcpu[0]))[3] >= 0
+        assert index.location(0) is None
+
+        found = pc.lookup(idcpu, comps=["x", int_name])
+        assert np.all(found["found"][:-1])
+        assert not found["found"][-1]
+        assert found["level"][-1] == -1
+        assert np.isnan(found["x"][-1])
+        assert np.array_equal(found["x"][:-1], columns["x"][::7])
+        assert np.all(found[int_name][:-1] == 33)
+
+        # moved particles are found again after redistribute
+        pc.redistribute()
+        found = pc.lookup(idcpu)
+        assert np.all(found["found"][:-1])
+        assert np.array_equal(found["x"][:-1], columns["x"][::7])
+        if not pc.is_soa_particle:
+            assert np.all(found["idata_0"][:-1] == 5)
+
+        # particles added by other methods are found, too
+        other = type(pc)(std_geometry, distmap, boxarr)
+        other.build_id_index()
+        other.copy_particles(pc, local=True)
+        assert np.all(other.lookup(idcpu)["found"][:-1])
+
+    ids = np.arange(-3, 1000, dtype=np.int64)
+    cpus = np.full(ids.shape, 7, dtype=np.int32)
+    idcpu = amr.pack_idcpu(ids, cpus)
+    assert np.array_equal(amr.unpack_ids(idcpu), ids)
+    assert np.array_equal(amr.unpack_cpus(idcpu), cpus)
+
+
+@pytest.mark.skipif(
+    importlib.util.find_spec("pyarrow") is None, reason="pyarrow is not available"
+)
+def test_pc_arrow(particle_container, soa_particle_container, Npart):
+    import pyarrow as pa
+
+    # pure SoA: one record batch per tile, zero-copy on CPU
+    pc = soa_particle_container
+    table = pa.table(pc)
+    columns = pc.to_columns()
+    assert table.column_names == list(columns.keys())
+    assert table.num_rows == pc.total_number_of_particles(True, True)
+    assert np.array_equal(table["x"].to_numpy(), columns["x"])
+
+    for tile in pc.get_particles(0).values():
+        batch = pa.record_batch(tile.get_struct_of_arrays())
+        assert batch.num_rows == tile.num_particles
+        assert np.all(batch["i0"].to_numpy() == 42)
+
+    # legacy: AoS columns are copied, named as in to_df
+    pc = particle_container
+    table = pa.table(pc)
+    assert len(table.column_names) == 14
+    assert table.num_rows == pc.total_number_of_particles(True, True)
+    for tile in pc.get_particles(0).values():
+        assert pa.record_batch(tile).num_rows == tile.num_particles
+
+
+def test_pti_remove_if(soa_particle_container, Npart):
+    pc = soa_particle_container
+
+    n_removed = 0
+    for lvl in range(pc.finest_level + 1):
+        for pti in pc.iterator(pc, level=lvl):
+            if pti.size == 0:
+                continue
+            x = pti.soa().to_numpy(copy=True).real["x"]
+            mask = x < 0.5
+            n_removed += np.count_nonzero(mask)
+
+            n_left = pti.remove_if(mask)
+            assert n_left == pti.num_particles == np.count_nonzero(~mask)
+            if n_left > 0:
+                soa = pti.soa().to_numpy()
+                assert np.all(soa.real["x"] >= 0.5)
+                assert np.all(soa.int["i0"] == 42)
+
+    assert pc.total_number_of_particles() == Npart - n_removed
+
+
+def test_pc_filter(particle_container, Npart):
+    pc = particle_container
+
+    # keep every other particle per tile
+    masks = {}
+    n_keep = 0
+    for tile_ind, pt in pc.get_particles(0).items():
+        mask = np.arange(pt.num_particles) % 2 == 0
+        masks[tile_ind] = mask
+        n_keep += np.count_nonzero(mask)
+
+    with pytest.raises(RuntimeError, match="no tile"):
+        pc.filter(0, {(-1, 0): np.ones(0, dtype=bool)})
+    with pytest.raises(RuntimeError, match="mask_fn"):
+        pc.filter(0, 0)
+    assert pc.filter(0, masks) == n_keep
+    assert pc.number_of_particles_at_level(0) == n_keep
+
+    # same again, but with a compiled C ABI kernel
+    MaskFn = ctypes.CFUNCTYPE(
+        None,
+        ctypes.c_int64,
+        ctypes.c_void_p,
+        ctypes.c_void_p,
+        ctypes.c_void_p,
+        ctypes.c_void_p,
+        ctypes.POINTER(ctypes.c_int),
+    )
+
+    def keep_even(num_particles, rdata, idata, idcpu, aos, mask):
+        for i in range(num_particles):
+            mask[i] = 1 if i % 2 == 0 else 0
+
+    c_keep_even = MaskFn(keep_even)
+    n_keep = sum((pt.num_particles + 1) // 2 for pt in pc.get_particles(0).values())
+
+    assert pc.filter(0, ctypes.cast(c_keep_even, ctypes.c_void_p).value) == n_keep
+    assert pc.number_of_particles_at_level(0) == n_keep
+    assert pc.OK()
+
+
+def test_pc_copy_particles(particle_container, std_geometry, distmap, boxarr):
+    pc = particle_container
+
+    def by_idcpu(columns):
+        order = np.argsort(columns["idcpu"])
+        return {name: column[order] for name, column in columns.items()}
+
+    expected = by_idcpu(pc.to_columns())
+
+    # another allocator: runtime components are added
+    pinned = amr.ParticleContainer_2_1_3_1_pinned(std_geometry, distmap, boxarr)
+    pinned.copy_particles(pc, local=True)
+    assert pinned.num_runtime_real_comps == 1
+    assert pinned.num_runtime_int_comps == 2
+    copied = by_idcpu(pinned.to_columns())
+    for name, column in expected.items():
+        assert np.array_equal(copied[name], column)
+
+    # add every other particle per tile, with a compiled C ABI kernel
+    MaskFn = ctypes.CFUNCTYPE(
+        None,
+        ctypes.c_int64,
+        ctypes.c_void_p,
+        ctypes.c_void_p,
+        ctypes.c_void_p,
+        ctypes.c_void_p,
+        ctypes.POINTER(ctypes.c_int),
+    )
+
+    def keep_even(num_particles, rdata, idata, idcpu, aos, mask):
+        for i in range(num_particles):
+            mask[i] = 1 if i % 2 == 0 else 0
+
+    c_keep_even = MaskFn(keep_even)
+    n_even = sum((pt.num_particles + 1) // 2 for pt in pc.get_particles(0).values())
+    pinned.add_particles(
+        pc, mask_fn=ctypes.cast(c_keep_even, ctypes.c_void_p).value, local=True
+    )
+    assert (
+        pinned.number_of_particles_at_level(0)
+        == pc.number_of_particles_at_level(0) + n_even
+    )
+
+    # legacy AoS + SoA to pure SoA: all columns are kept, in order
+    soa = amr.ParticleContainer_pureSoA_3_0_default(std_geometry, distmap, boxarr)
+    soa.copy_particles(pc)
+    assert soa.num_real_comps == 9
+    assert soa.num_int_comps == 4
+    converted = by_idcpu(soa.to_columns())
+    assert np.array_equal(converted["x"], expected["x"])
+    assert np.array_equal(converted["a"], expected["rdata_0"])
+    assert np.all(converted["i0"] == 5)
+    assert np.all(converted["i3"] == 33)
+
+    # and back, setting SoA int 0 of the copies
+    TransformFn = ctypes.CFUNCTYPE(
+        None,
+        ctypes.c_int64,
+        ctypes.c_void_p,
+        ctypes.POINTER(ctypes.POINTER(ctypes.c_int)),
+        ctypes.c_void_p,
+        ctypes.c_void_p,
+    )
+
+    def set_i0(num_particles, rdata, idata, idcpu, aos):
+        for i in range(num_particles):
+            idata[0][i] = 7
+
+    c_set_i0 = TransformFn(set_i0)
+    legacy = amr.ParticleContainer_2_1_3_1_default(std_geometry, distmap, boxarr)
+    legacy.copy_particles(
+        soa, transform_fn=ctypes.cast(c_set_i0, ctypes.c_void_p).value
+    )
+    round_trip = by_idcpu(legacy.to_columns())
+    assert np.all(round_trip["SoA_i0"] == 7)
+    for name, column in expected.items():
+        if name != "SoA_i0":
+            assert np.array_equal(round_trip[name], column)
+
+
+def test_pc_particles_at(soa_particle_container, std_geometry, distmap, boxarr):
+    pc = soa_particle_container
+
+    tiles = pc.get_particles(0)
+    keys = pc.tile_keys(0)
+    assert keys.shape == (len(tiles), 2)
+    for grid, tile in keys:
+        ptile = pc.particles_at(0, grid, tile)
+        assert ptile.num_particles == tiles[(grid, tile)].num_particles
+    with pytest.raises(RuntimeError):
+        pc.particles_at(0, -1, 0)
+    with pytest.raises(RuntimeError):
+        pc.tile_keys(pc.finest_level + 1)
+
+    # fill the same tiles of another container directly
+    other = amr.ParticleContainer_pureSoA_8_0_default(std_geometry, distmap, boxarr)
+    other.add_real_comp(True)
+    other.add_int_comp(True)
+    other.add_int_comp(True)
+    for grid, tile in keys:
+        ptile = other.define_and_return_particle_tile(0, grid, tile)
+        ptile.resize(3)
+        assert other.particles_at(0, grid, tile).num_particles == 3
+    assert np.array_equal(other.tile_keys(0), keys)
+    with pytest.raises(RuntimeError):
+        other.define_and_return_particle_tile(0, boxarr.size, 0)
+
+
+def test_pc_increment(particle_container, soa_particle_container, distmap, boxarr):
+    for pc in [particle_container, soa_particle_container]:
+        np_total = pc.total_number_of_particles()
+
+        # same grids as the particles: count into component 1
+        mf = amr.MultiFab(boxarr, distmap, 2, 1)
+        mf.set_val(0.0)
+        assert pc.increment(mf, 0, comp=1) == np_total
+        assert mf.sum(0) == 0.0
+        assert mf.sum(1) == np_total
+        assert pc.increment_with_total(mf, 0) == np_total
+        assert mf.sum(0) == np_total
+
+        # other grids
+        ba = amr.BoxArray(boxarr.minimal_box())
+        ba.max_size(16)
+        counts = amr.MultiFab(ba, amr.DistributionMapping(ba), 1, 0)
+        counts.set_val(0.0)
+        n_local = pc.increment(counts, 0, local=True)
+        assert n_local == pc.total_number_of_particles(True, True)
+        assert counts.sum(0) == np_total
+
+        with pytest.raises(RuntimeError):
+            pc.increment(mf, 0, comp=2)
+
+
+def test_pc_build_bins(soa_particle_container, std_geometry):
+    pc = soa_particle_container
+    dx = std_geometry.data().CellSize()
+
+    for pti in pc.iterator(pc, level=0):
+        np_tile = pti.num_particles
+        bins = pti.build_bins()
+        permutation = bins.permutation
+        offsets = bins.offsets
+        assert len(bins) == bins.box.num_pts
+        assert bins.num_items == np_tile
+        assert offsets.shape == (len(bins) + 1,)
+        assert offsets[-1] == np_tile
+        assert np.array_equal(np.sort(permutation), np.arange(np_tile))
+
+        # every particle is in the bin of its cell, x is the fastest index
+        soa = pti.soa().to_numpy()
+        lo = bins.box.small_end
+        shape = bins.bin_box.length()
+        cell = [
+            np.floor(soa.real[name] / dx[d]).astype(int) - lo[d]
+            for d, name in enumerate(["x", "y", "z"])
+        ]
+        expected = cell[0] + shape[0] * (cell[1] + shape[1] * cell[2])
+        bin_of_item = np.repeat(np.arange(len(bins)), np.diff(offsets))
+        assert np.array_equal(expected[permutation], bin_of_item)
+
+        # larger bins
+        bins2 = pti.build_bins(amr.IntVect(2, 2, 2))
+        assert len(bins2) * 8 == len(bins)
+        assert bins2.offsets[-1] == np_tile
+
+    with pytest.raises(RuntimeError):
+        next(iter(pc.iterator(pc, level=0))).build_bins(amr.IntVect(0, 1, 1))
+
+
+def test_pc_tiles(soa_particle_container):
+    pc = soa_particle_container
+    n_local = pc.number_of_particles_at_level(0)
+
+    assert len(pc.tile_size) == 3
+    assert isinstance(pc.do_tiling, bool)
+
+    # Python loop over tiles with dynamic scheduling
+    info = amr.MFItInfo()
+    info.set_dynamic(True)
+    n = 0
+    for pti in pc.iterator(pc, level=0, info=info):
+        n += pti.num_particles
+    assert n == n_local
+
+    # compiled C ABI kernel per tile: set int component 0
+    TileFn = ctypes.CFUNCTYPE(
+        None,
+        ctypes.c_int64,
+        ctypes.c_void_p,
+        ctypes.POINTER(ctypes.POINTER(ctypes.c_int)),
+        ctypes.c_void_p,
+        ctypes.c_void_p,
+    )
+    counts = []
+
+    def set_i0(num_particles, rdata, idata, idcpu, aos):
+        counts.append(num_particles)
+        for i in range(num_particles):
+            idata[0][i] = 11
+
+    c_set_i0 = TileFn(set_i0)
+    pc.parallel_for_tiles(ctypes.cast(c_set_i0, ctypes.c_void_p).value)
+    assert sum(counts) == n_local
+    assert np.all(pc.to_columns()["i0"] == 11)
+    with pytest.raises(RuntimeError, match="tile_fn"):
+        pc.parallel_for_tiles(0)
+
+
+@pytest.mark.parametrize("key", [0, "morton", "hilbert"])
+def test_pc_sort_by(soa_particle_container, Npart, key):
+    pc = soa_particle_container
+
+    def particles_by_id():
+        by_id = {}
+        for pti in pc.const_iterator(pc, level=0):
+            if pti.size == 0:
+                continue
+            soa = pti.soa().to_numpy(copy=True)
+            for i, idcpu in enumerate(soa.idcpu):
+                by_id[idcpu] = (soa.real["x"][i], soa.real["y"][i], soa.int["i1"][i])
+        return by_id
+
+    before = particles_by_id()
+    pc.sort_by(key)
+    after = particles_by_id()
+
+    # same particles with the same attributes, only reordered
+    assert before == after
+    assert pc.total_number_of_particles() == Npart
+
+    if key == 0:
+        for pti in pc.const_iterator(pc, level=0):
+            if pti.size == 0:
+                continue
+            x = pti.soa().to_numpy().real["x"]
+            assert np.all(np.diff(x) >= 0.0)
+
+        # NaN keys are ordered last
+        for pti in pc.iterator(pc, level=0):
+            pti.soa().to_numpy().real["x"][::3] = np.nan
+        pc.sort_by(key)
+        for pti in pc.const_iterator(pc, level=0):
+            x = pti.soa().to_numpy().real["x"]
+            num_nan = np.count_nonzero(np.isnan(x))
+            assert np.all(np.isnan(x[x.size - num_nan :]))
+            assert np.all(np.diff(x[: x.size - num_nan]) >= 0.0)
+
+
+def test_pc_sort_by_offset_domain():
+    # the domain does not start at cell 0
+    domain = amr.Box(amr.IntVect(16, 16, 16), amr.IntVect(31, 31, 31))
+    real_box = amr.RealBox(0, 0, 0, 1.0, 1.0, 1.0)
+    geom = amr.Geometry(domain, real_box, 0, [0, 0, 0])
+    ba = amr.BoxArray(domain)
+    dm = amr.DistributionMapping(ba)
+
+    pc = amr.ParticleContainer_pureSoA_8_0_default(geom, dm, ba)
+    init_data = amr.ParticleInitType_pureSoA_8_0()
+    init_data.real_array_data = [0.1, 0.2, 0.3, 0.4, 0.5, 0.6, 0.7, 0.8]
+    init_data.int_array_data = []
+    pc.init_random(1000, 7, init_data, False, real_box)
+    pc.sort_by("morton")
+
+    # Morton keys of the cells relative to the domain corner, x in the lowest bit
+    for pti in pc.const_iterator(pc, level=0):
+        real = pti.soa().to_numpy().real
+        cells = [
+            np.minimum(np.floor(real[name] * 16.0).astype(np.int64), 15)
+            for name in ["x", "y", "z"]
+        ]
+        keys = sum(
+            ((cells[d] >> b) & 1) << (3 * b + d) for b in range(4) for d in range(3)
+        )
+        assert np.all(np.diff(keys) >= 0)
+
+
+@pytest.mark.parametrize("layout", ["pureSoA_8_0", "2_1_3_1"])
+def test_pc_ghost_and_virtual_particles(layout):
+    # two levels, the fine grid touches the periodic z boundary
+    real_box = amr.RealBox(0, 0, 0, 1.0, 1.0, 1.0)
+    coarse = amr.Box(amr.IntVect(0, 0, 0), amr.IntVect(63, 63, 63))
+    fine = amr.Box(amr.IntVect(0, 0, 0), amr.IntVect(127, 127, 127))
+    geoms = amr.Vector_Geometry(
+        [
+            amr.Geometry(coarse, real_box, 0, [1, 1, 1]),
+            amr.Geometry(fine, real_box, 0, [1, 1, 1]),
+        ]
+    )
+    coarse_ba = amr.BoxArray(coarse)
+    coarse_ba.max_size(32)
+    fine_ba = amr.BoxArray(amr.Box(amr.IntVect(32, 32, 112), amr.IntVect(95, 95, 127)))
+    dms = amr.Vector_DistributionMapping(
+        [amr.DistributionMapping(coarse_ba), amr.DistributionMapping(fine_ba)]
+    )
+    bas = amr.Vector_BoxArray([coarse_ba, fine_ba])
+    ratios = amr.Vector_IntVect([amr.IntVect(2, 2, 2)])
+
+    pc = getattr(amr, f"ParticleContainer_{layout}_default")(geoms, dms, bas, ratios)
+    init_data = getattr(amr, f"ParticleInitType_{layout}")()
+    if layout == "pureSoA_8_0":
+        init_data.real_array_data = [0.1, 0.2, 0.3, 0.4, 0.5, 0.6, 0.7, 0.8]
+        init_data.int_array_data = []
+    else:
+        init_data.real_struct_data = [0.5, 0.6]
+        init_data.int_struct_data = [5]
+        init_data.real_array_data = [0.5, 0.2, 0.3]
+        init_data.int_array_data = [1]
+    pc.init_random(10000, 1, init_data, False, real_box)
+    pc.add_real_comp(True)
+    assert pc.finest_level == 1
+
+    # expected: periodic images of coarse particles within ngrow fine cells of the fine grid
+    ngrow = 2
+    columns = pc.to_columns(level=0, comps=["x", "y", "z"])
+    pos = np.stack([columns["x"], columns["y"], columns["z"]])
+    lo = np.array([32, 32, 112])[:, None] - ngrow
+    hi = np.array([95, 95, 127])[:, None] + ngrow
+    expected = 0
+    for shift in itertools.product([-1.0, 0.0, 1.0], repeat=3):
+        cell = np.floor((pos + np.array(shift)[:, None]) * 128.0)
+        expected += np.count_nonzero(np.all((cell >= lo) & (cell <= hi), axis=0))
+    assert expected > 0
+
+    tile_type = getattr(amr, f"ParticleTile_{layout}_default")
+    ghosts = tile_type()
+    assert pc.create_ghost_particles(0, ngrow, ghosts) == expected
+    assert ghosts.num_particles == expected
+    if layout == "pureSoA_8_0":
+        soa = ghosts.get_struct_of_arrays()
+        ids = (soa.get_idcpu_data().to_numpy() >> 24) & 0x7FFFFFFFFF
+        assert np.all(ids == 2**39 - 1)  # GhostParticleID
+        z = soa.get_real_data(2).to_numpy()
+        assert np.any(z > 1.0)  # periodic images above the domain
+    with pytest.raises(RuntimeError):
+        pc.create_ghost_particles(1, ngrow, ghosts)
+
+    # valid fine particles are virtual particles of the coarse level
+    if layout == "pureSoA_8_0":
+        # invalidate the first particle of each tile
+        for pti in pc.iterator(pc, level=1):
+            if pti.size > 0:
+                pti.soa().get_idcpu_data().to_numpy()[0] = 0
+    n_fine = pc.number_of_particles_at_level(1, True, True)
+    virts = tile_type()
+    assert pc.create_virtual_particles(1, virts) == n_fine
+    assert pc.create_virtual_particles(1, virts) == n_fine
+    assert virts.num_particles == 2 * n_fine
+    with pytest.raises(RuntimeError):
+        pc.create_virtual_particles(0, virts)
+
+
+def test_pc_collide_pairs():
+    # few cells, many particles per cell
+    real_box = amr.RealBox(0, 0, 0, 1.0, 1.0, 1.0)
+    domain = amr.Box(amr.IntVect(0, 0, 0), amr.IntVect(7, 7, 7))
+    geom = amr.Geometry(domain, real_box, 0, [1, 1, 1])
+    ba = amr.BoxArray(domain)
+    ba.max_size(4)
+    dm = amr.DistributionMapping(ba)
+
+    def make_species(num_particles, seed):
+        pc = amr.ParticleContainer_pureSoA_8_0_default(geom, dm, ba)
+        init_data = amr.ParticleInitType_pureSoA_8_0()
+        init_data.real_array_data = [0.1, 0.2, 0.3, 0.4, 0.5, 0.6, 0.7, 0.8]
+        init_data.int_array_data = []
+        pc.init_random(num_particles, seed, init_data, False, real_box)
+        pc.add_int_comp(True)
+        for pti in pc.iterator(pc, level=0):
+            pti.soa().get_int_data(0).assign(0)
+        return pc
+
+    def cell_counts(pc):
+        return {
+            pti.pair_index: np.diff(pti.build_bins().offsets)
+            for pti in pc.iterator(pc, level=0)
+        }
+
+    def collisions(pc):
+        return sum(
+            pti.soa().to_numpy().int["i0"].sum() for pti in pc.iterator(pc, level=0)
+        )
+
+    # count the collisions of each particle in int component 0
+    PairFn = ctypes.CFUNCTYPE(
+        None,
+        ctypes.c_int64,
+        ctypes.POINTER(ctypes.c_int),
+        ctypes.POINTER(ctypes.c_int),
+        ctypes.POINTER(ctypes.c_int),
+        ctypes.POINTER(ctypes.c_int),
+        ctypes.c_void_p,
+        ctypes.POINTER(ctypes.POINTER(ctypes.c_int)),
+        ctypes.c_void_p,
+        ctypes.c_void_p,
+        ctypes.c_void_p,
+        ctypes.POINTER(ctypes.POINTER(ctypes.c_int)),
+        ctypes.c_void_p,
+        ctypes.c_void_p,
+    )
+    bad_pairs = []
+
+    def count(npairs, ia, ib, na, nb, ra, ida, ca, aa, rb, idb, cb, ab):
+        for k in range(npairs):
+            if ra == rb and (ia[k] == ib[k] or na[k] < 2):
+                bad_pairs.append(k)
+            ida[0][ia[k]] += 1
+            idb[0][ib[k]] += 1
+
+    c_count = PairFn(count)
+    fn_ptr = ctypes.cast(c_count, ctypes.c_void_p).value
+
+    # one species: n // 2 pairs per cell, plus one for odd n
+    pc_a = make_species(2000, 1)
+    expected = sum(
+        np.sum(np.where(n >= 2, (n + 1) // 2, 0)) for n in cell_counts(pc_a).values()
+    )
+    npairs = pc_a.collide_pairs(fn_ptr, 0, seed=7)
+    assert npairs == expected
+    assert bad_pairs == []
+    assert collisions(pc_a) == 2 * npairs
+
+    # pairs are reproducible for a fixed seed and differ without one
+    pairs = []
+
+    def record(npairs, ia, ib, *args):
+        pairs.append(tuple((ia[k], ib[k]) for k in range(npairs)))
+
+    c_record = PairFn(record)
+    record_ptr = ctypes.cast(c_record, ctypes.c_void_p).value
+
+    def paired(**kwargs):
+        pairs.clear()
+        pc_a.collide_pairs(record_ptr, 0, **kwargs)
+        return sorted(pairs)
+
+    assert paired(seed=7) == paired(seed=7)
+    assert paired() != paired()
+    with pytest.raises(RuntimeError, match="pair_fn"):
+        pc_a.collide_pairs(0, 0)
+
+    # two species: max(n_a, n_b) pairs per cell with both species
+    pc_b = make_species(500, 2)
+    counts_a = cell_counts(pc_a)
+    counts_b = cell_counts(pc_b)
+    expected = sum(
+        np.sum(
+            np.where((n_a > 0) & (counts_b[key] > 0), np.maximum(n_a, counts_b[key]), 0)
+        )
+        for key, n_a in counts_a.items()
+        if key in counts_b
+    )
+    n_before = collisions(pc_a)
+    npairs = pc_a.collide_pairs(fn_ptr, 0, species_b=pc_b, seed=7)
+    assert npairs == expected
+    assert collisions(pc_a) - n_before == npairs
+    assert collisions(pc_b) == npairs
+
+    # other grids
+    ba2 = amr.BoxArray(domain)
+    pc_c = amr.ParticleContainer_pureSoA_8_0_default(
+        geom, amr.DistributionMapping(ba2), ba2
+    )
+    with pytest.raises(RuntimeError):
+        pc_a.collide_pairs(fn_ptr, 0, species_b=pc_c)
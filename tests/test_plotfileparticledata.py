@@ -158,3 +158,136 @@ def test_plotfile_particle_data_read():
 
     # clean up after yourself
     shutil.rmtree(plt_file_name)
+
+
+@pytest.mark.skipif(amr.Config.spacedim != 3, reason="Requires AMREX_SPACEDIM = 3")
+def test_plotfile_particle_reader():
+    """
+    Generate a plot file containing particle data and read it without a
+    particle container.
+    """
+    random.seed(1)
+
+    plt_file_name = "plt_test_reader"
+    n_part = 15
+    reference_part = generate_test_particles(n_part)
+    write_test_plotfile(plt_file_name, reference_part)
+
+    reader = amr.ParticlePlotFileReader(plt_file_name, "particles")
+    assert reader.num_particles == n_part
+    assert reader.real_comp_names[:3] == ["x", "y", "z"]
+    assert len(reader.real_comp_names) == 3 + 16
+    assert len(reader.int_comp_names) == 4
+    assert len(reader.boxes(0)) == reader.num_grids(0)
+
+    # selected columns of all grids
+    idx_name = reader.int_comp_names[0]
+    columns = reader.columns(["x", "y", "z", idx_name], max_workers=2)
+    assert len(columns["x"]) == n_part
+    for x, y, z, idx in zip(
+        columns["x"], columns["y"], columns["z"], columns[idx_name]
+    ):
+        assert Particle(x=x, y=y, z=z, idx=idx) == reference_part[idx]
+
+    # lazy columns per grid
+    counts = [
+        len(reader.grid_columns(0, grid, ["x"])["x"])
+        for grid in range(reader.num_grids(0))
+    ]
+    assert sum(counts) == n_part
+    assert len(np.unique(reader.columns(["idcpu"])["idcpu"])) == n_part
+
+    # clean up after yourself
+    shutil.rmtree(plt_file_name)
+
+
+@pytest.mark.skipif(amr.Config.spacedim != 3, reason="Requires AMREX_SPACEDIM = 3")
+def test_async_writer():
+    """
+    Write mesh and particle data with an AsyncWriter, change the data while
+    writing, and check that the snapshots were written.
+    """
+    random.seed(1)
+
+    plt_file_name = "plt_test_async"
+    n_part = 15
+    reference_part = generate_test_particles(n_part)
+
+    domain_box = amr.Box([0, 0, 0], [31, 31, 31])
+    real_box = amr.RealBox([-0.5, -0.5, -0.5], [0.5, 0.5, 0.5])
+    geom = amr.Geometry(domain_box, real_box, amr.CoordSys.cartesian, [0, 0, 0])
+    ba = amr.BoxArray(domain_box)
+    dm = amr.DistributionMapping(ba, 1)
+    mf = amr.MultiFab(ba, dm, 1, 0)
+    mf.set_val(np.pi)
+    pc = particle_container(reference_part, geom, dm, ba, real_box)
+
+    var_names = amr.Vector_string(["density"])
+    with amr.AsyncWriter(max_bytes=2**26) as writer:
+        mesh_written = writer.write_single_level_plotfile(
+            plt_file_name, mf, var_names, geom, 1.0, 200
+        )
+        particles_written = writer.write_plotfile(pc, plt_file_name, "particles")
+        mf.set_val(0.0)
+        pc.clear_particles()
+        particles_written.result()
+    assert mesh_written.done()
+
+    plt = amr.PlotFileData(plt_file_name)
+    density = plt.get(0, "density")
+    for mfi in density:
+        assert np.all(density.array(mfi).to_xp() == np.pi)
+
+    reader = amr.ParticlePlotFileReader(plt_file_name, "particles")
+    assert reader.num_particles == n_part
+    check_particles_container(
+        load_test_plotfile_particle_container(plt_file_name), reference_part
+    )
+
+    # clean up after yourself
+    shutil.rmtree(plt_file_name)
+
+
+@pytest.mark.skipif(amr.Config.spacedim != 3, reason="Requires AMREX_SPACEDIM = 3")
+def test_async_writer_synchronous_fallback():
+    """
+    A write larger than max_bytes runs synchronously, after the pending writes.
+    """
+    random.seed(1)
+
+    mesh_file_name = "plt_test_async_fallback_mesh"
+    particle_file_name = "plt_test_async_fallback_particles"
+    n_part = 15
+    reference_part = generate_test_particles(n_part)
+
+    domain_box = amr.Box([0, 0, 0], [31, 31, 31])
+    real_box = amr.RealBox([-0.5, -0.5, -0.5], [0.5, 0.5, 0.5])
+    geom = amr.Geometry(domain_box, real_box, amr.CoordSys.cartesian, [0, 0, 0])
+    ba = amr.BoxArray(domain_box)
+    dm = amr.DistributionMapping(ba, 1)
+    mf = amr.MultiFab(ba, dm, 1, 0)
+    mf.set_val(np.pi)
+    pc = particle_container(reference_part, geom, dm, ba, real_box)
+
+    # the particles fit the budget, the mesh does not
+    var_names = amr.Vector_string(["density"])
+    with amr.AsyncWriter(max_bytes=2**14) as writer:
+        particles_written = writer.write_plotfile(pc, particle_file_name, "particles")
+        mesh_written = writer.write_single_level_plotfile(
+            mesh_file_name, mf, var_names, geom, 1.0, 200
+        )
+        assert mesh_written.done()
+        assert particles_written.done()
+        mesh_written.result()
+        particles_written.result()
+
+    reader = amr.ParticlePlotFileReader(particle_file_name, "particles")
+    assert reader.num_particles == n_part
+    plt = amr.PlotFileData(mesh_file_name)
+    density = plt.get(0, "density")
+    for mfi in density:
+        assert np.all(density.array(mfi).to_xp() == np.pi)
+
+    # clean up after yourself
+    shutil.rmtree(mesh_file_name)
+    shutil.rmtree(particle_file_name)
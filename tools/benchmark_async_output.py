@@ -0,0 +1,102 @@
+"""
+Benchmark synchronous and asynchronous (AsyncWriter) plotfile output.
+
+Each step does some mesh and particle work, then writes a mesh plotfile with
+particles. The time the step is blocked by output is reported, once writing
+synchronously and once with amr.AsyncWriter, which only snapshots the data
+on the step and writes on a background thread.
+
+Usage:
+  python3 tools/benchmark_async_output.py [num_particles] [steps] [outdir]
+
+Without outdir, plotfiles are written to ./benchmark_async_output and removed.
+Each mode writes to its own subdirectory, sync/ and async/, so that no
+plotfile of the other run is renamed to .old.* during the timed writes.
+"""
+
+import shutil
+import sys
+import time
+
+import amrex.space3d as amr
+
+
+def work(pc, mf):
+    """Stand-in for a simulation step"""
+    for _ in range(5):
+        mf.plus(1.0, 0, mf.n_comp, 0)
+        pc.redistribute()
+
+
+def run(pc, mf, geom, var_names, steps, outdir, writer=None):
+    """Wall-clock time of all steps and of output on the steps"""
+    output = 0.0
+    start = time.perf_counter()
+    for step in range(steps):
+        work(pc, mf)
+
+        plotfile = f"{outdir}/plt{step:05d}"
+        start_output = time.perf_counter()
+        if writer is None:
+            amr.write_single_level_plotfile(plotfile, mf, var_names, geom, step, step)
+            pc.write_plotfile(plotfile, "particles")
+        else:
+            writer.write_single_level_plotfile(
+                plotfile, mf, var_names, geom, step, step
+            )
+            writer.write_plotfile(pc, plotfile, "particles")
+        output += time.perf_counter() - start_output
+
+    if writer is not None:
+        writer.wait()
+    return time.perf_counter() - start, output
+
+
+def main(num_particles=2_000_000, steps=5, outdir=None):
+    amr.initialize([])
+
+    domain = amr.Box(amr.IntVect(0, 0, 0), amr.IntVect(127, 127, 127))
+    real_box = amr.RealBox(0, 0, 0, 1.0, 1.0, 1.0)
+    geom = amr.Geometry(domain, real_box, 0, [0, 0, 0])
+    ba = amr.BoxArray(domain)
+    ba.max_size(64)
+    dm = amr.DistributionMapping(ba)
+
+    ncomp = 4
+    mf = amr.MultiFab(ba, dm, ncomp, 0)
+    mf.set_val(0.0)
+    var_names = amr.Vector_string([f"comp{i}" for i in range(ncomp)])
+
+    init_data = amr.ParticleInitType_2_1_3_1()
+    init_data.real_struct_data = [0.5, 0.6]
+    init_data.int_struct_data = [5]
+    init_data.real_array_data = [0.5, 0.2, 0.3]
+    init_data.int_array_data = [1]
+    pc = amr.ParticleContainer_2_1_3_1_default(geom, dm, ba)
+    pc.init_random(num_particles, 42, init_data, False, real_box)
+
+    tmpdir = outdir or "benchmark_async_output"
+    try:
+        total, output = run(pc, mf, geom, var_names, steps, f"{tmpdir}/sync")
+        amr.Print(
+            f"synchronous:  total {total:.3f} s, blocked by output {output:.3f} s"
+        )
+
+        with amr.AsyncWriter() as writer:
+            total, output = run(
+                pc, mf, geom, var_names, steps, f"{tmpdir}/async", writer
+            )
+        amr.Print(
+            f"asynchronous: total {total:.3f} s, blocked by output {output:.3f} s"
+        )
+    finally:
+        if outdir is None and amr.ParallelDescriptor.IOProcessor():
+            shutil.rmtree(tmpdir, ignore_errors=True)
+
+    del pc, mf
+    amr.finalize()
+
+
+if __name__ == "__main__":
+    args = sys.argv[1:4]
+    main(*[int(arg) for arg in args[:2]], *args[2:])
@@ -0,0 +1,98 @@
+"""
+Benchmark ghost particle creation against a NumPy reimplementation.
+
+Particles on the coarse level of a two-level hierarchy are copied, with their
+periodic images, if they are within ngrow cells of the fine grids. This is
+done once with pc.create_ghost_particles, which runs in parallel over tiles
+in C++, and once in NumPy from pc.to_columns, which only selects and shifts
+the positions.
+
+Usage:
+  python3 tools/benchmark_ghost_particles.py [num_particles] [repeats] [ngrow]
+"""
+
+import itertools
+import sys
+import time
+
+import numpy as np
+
+import amrex.space3d as amr
+
+
+def numpy_ghosts(pc, fine_boxes, ngrow, ncells=128):
+    """Positions of the ghost particles of level 0, computed in NumPy"""
+    columns = pc.to_columns(level=0, comps=["x", "y", "z"])
+    pos = np.stack([columns["x"], columns["y"], columns["z"]])
+
+    ghosts = []
+    for shift in itertools.product([-1.0, 0.0, 1.0], repeat=3):
+        shifted = pos + np.array(shift)[:, None]
+        cell = np.floor(shifted * ncells)
+        near = np.zeros(pos.shape[1], dtype=bool)
+        for lo, hi in fine_boxes:
+            near |= np.all(
+                (cell >= np.array(lo)[:, None] - ngrow)
+                & (cell <= np.array(hi)[:, None] + ngrow),
+                axis=0,
+            )
+        ghosts.append(shifted[:, near])
+    return np.concatenate(ghosts, axis=1)
+
+
+def main(num_particles=2_000_000, repeats=5, ngrow=2):
+    amr.initialize([])
+
+    real_box = amr.RealBox(0, 0, 0, 1.0, 1.0, 1.0)
+    coarse = amr.Box(amr.IntVect(0, 0, 0), amr.IntVect(63, 63, 63))
+    fine = amr.Box(amr.IntVect(0, 0, 0), amr.IntVect(127, 127, 127))
+    geoms = amr.Vector_Geometry(
+        [
+            amr.Geometry(coarse, real_box, 0, [1, 1, 1]),
+            amr.Geometry(fine, real_box, 0, [1, 1, 1]),
+        ]
+    )
+    coarse_ba = amr.BoxArray(coarse)
+    coarse_ba.max_size(32)
+    # the fine grid touches the periodic z boundary
+    fine_boxes = [((32, 32, 96), (95, 95, 127))]
+    fine_ba = amr.BoxArray(
+        amr.Box(amr.IntVect(*fine_boxes[0][0]), amr.IntVect(*fine_boxes[0][1]))
+    )
+    fine_ba.max_size(32)
+    dms = amr.Vector_DistributionMapping(
+        [amr.DistributionMapping(coarse_ba), amr.DistributionMapping(fine_ba)]
+    )
+    bas = amr.Vector_BoxArray([coarse_ba, fine_ba])
+    ratios = amr.Vector_IntVect([amr.IntVect(2, 2, 2)])
+
+    init_data = amr.ParticleInitType_pureSoA_8_0()
+    init_data.real_array_data = [0.1, 0.2, 0.3, 0.4, 0.5, 0.6, 0.7, 0.8]
+    init_data.int_array_data = []
+    pc = amr.ParticleContainer_pureSoA_8_0_default(geoms, dms, bas, ratios)
+    pc.init_random(num_particles, 42, init_data, False, real_box)
+
+    start = time.perf_counter()
+    for _ in range(repeats):
+        ghosts = amr.ParticleTile_pureSoA_8_0_default()
+        n = pc.create_ghost_particles(0, ngrow, ghosts)
+    t_pc = (time.perf_counter() - start) / repeats
+
+    start = time.perf_counter()
+    for _ in range(repeats):
+        n_np = numpy_ghosts(pc, fine_boxes, ngrow).shape[1]
+    t_np = (time.perf_counter() - start) / repeats
+
+    if n != n_np:
+        raise RuntimeError(f"ghost counts differ: {n} vs. {n_np}")
+
+    amr.Print(f"{n} ghost particles of {num_particles} particles, ngrow={ngrow}")
+    amr.Print(f"create_ghost_particles: {t_pc:.4f} s")
+    amr.Print(f"NumPy (positions only): {t_np:.4f} s")
+
+    del pc
+    amr.finalize()
+
+
+if __name__ == "__main__":
+    main(*[int(arg) for arg in sys.argv[1:4]])
@@ -0,0 +1,66 @@
+"""
+Benchmark particle-to-mesh deposition before and after sorting particles.
+
+Particles are deposited (counted per cell) with ParticleContainer.increment,
+once in their random initial order and once after each sort_by key.
+
+Usage:
+  python3 tools/benchmark_sort_deposition.py [num_particles] [repetitions]
+"""
+
+import sys
+import time
+
+import amrex.space3d as amr
+
+
+def time_deposition(pc, mf, repetitions):
+    """Best wall-clock time of repeated per-cell particle counting"""
+    best = float("inf")
+    for _ in range(repetitions):
+        mf.set_val(0.0)
+        start = time.perf_counter()
+        pc.increment(mf, 0)
+        best = min(best, time.perf_counter() - start)
+    return best
+
+
+def main(num_particles=4_000_000, repetitions=5):
+    amr.initialize([])
+
+    domain = amr.Box(amr.IntVect(0, 0, 0), amr.IntVect(127, 127, 127))
+    real_box = amr.RealBox(0, 0, 0, 1.0, 1.0, 1.0)
+    geom = amr.Geometry(domain, real_box, 0, [0, 0, 0])
+    ba = amr.BoxArray(domain)
+    ba.max_size(64)
+    dm = amr.DistributionMapping(ba)
+
+    mf = amr.MultiFab(ba, dm, 1, 0)
+
+    init_data = amr.ParticleInitType_2_1_3_1()
+    init_data.real_struct_data = [0.5, 0.6]
+    init_data.int_struct_data = [5]
+    init_data.real_array_data = [0.5, 0.2, 0.3]
+    init_data.int_array_data = [1]
+
+    for key in [None, "morton", "hilbert"]:
+        pc = amr.ParticleContainer_2_1_3_1_default(geom, dm, ba)
+        pc.init_random(num_particles, 42, init_data, False, real_box)
+
+        label = "unsorted"
+        if key is not None:
+            start = time.perf_counter()
+            pc.sort_by(key)
+            label = f"{key} (sort: {time.perf_counter() - start:.3f} s)"
+
+        t = time_deposition(pc, mf, repetitions)
+        amr.Print(f"deposition {label}: {t:.4f} s")
+
+        del pc
+
+    del mf
+    amr.finalize()
+
+
+if __name__ == "__main__":
+    main(*[int(arg) for arg in sys.argv[1:3]])